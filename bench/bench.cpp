@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "calculator.h"
+#include "fast_case_parser.h"
+#include "hiker_pool.h"
+#include "thread_pool.h"
+#include "case_generator.h"
+#include "differential.h"
+#include "load_generator.h"
+
+
+using std::string;
+using std::vector;
+
+namespace {
+
+struct Scenario {
+    const char* name;
+    CaseSpec spec;
+    // The greedy and dp engines go over every group at each bridge, too
+    // slow for many bridges.
+    bool greedy;
+};
+
+const Scenario kScenarios[] = {
+    {"uniform", {1000, 2000, 4, SpeedDistribution::Uniform, 1}, true},
+    {"equal", {1000, 2000, 4, SpeedDistribution::Equal, 2}, true},
+    {"threshold", {1000, 2000, 4, SpeedDistribution::Threshold, 3}, true},
+    {"heavy-tailed", {1000, 2000, 4, SpeedDistribution::HeavyTailed, 4}, true},
+    {"many-bridges", {8, 20000, 1, SpeedDistribution::Uniform, 5}, false},
+    {"many-hikers", {100000, 20, 1000, SpeedDistribution::HeavyTailed, 6}, true},
+};
+
+// Metric name -> value, lower is better.
+typedef std::map<string, double> Metrics;
+
+template <typename Run>
+double best_seconds(int reps, Run run)
+{
+    double best = 0;
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+long peak_rss_kb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void report(const string& scenario, const char* phase, double seconds,
+    size_t items, const char* unit)
+{
+    std::cout << std::left << std::setw(14) << scenario << std::setw(20) << phase
+        << std::right << std::fixed << std::setprecision(3)
+        << std::setw(10) << seconds * 1e3 << " ms"
+        << std::setprecision(0) << std::setw(14) << items / seconds << " " << unit << "/s\n";
+}
+
+// The default engine may take this many times the faster of the engines it
+// picks from (Greedy and Incremental) on a scenario before the bench fails.
+const double kAutoSlack = 2.0;
+
+// Time parsing, sorting and each engine on one scenario. Return false if
+// the engines disagree, or the default engine picks a slow one.
+bool run_scenario(const Scenario& scenario, int reps, Metrics& metrics)
+{
+    const CaseSpec& spec = scenario.spec;
+    string strCase = generate_case(spec);
+    size_t hikerCount = spec.hikerCount + spec.bridgeCount * spec.arrivalsPerBridge;
+    string name = scenario.name;
+
+    vector<Hiker> origHikers;
+    vector<Bridge> bridges;
+    CaseParseError error;
+    double parseTime = best_seconds(reps, [&]() {
+        origHikers.clear();
+        bridges.clear();
+        if (!FastCaseParser().parse(strCase, origHikers, bridges, error)) {
+            std::cerr << name << ": parse error at " << error.position << ": "
+                << error.message << std::endl;
+            std::exit(2);
+        }
+    });
+    report(name, "parse", parseTime, hikerCount, "hikers");
+    metrics[name + ".parse_ns_per_hiker"] = parseTime * 1e9 / hikerCount;
+
+    const HikerPool* pool = bridges.back().getHikerPool();
+    if (pool) {
+        vector<HikerPool> copies(reps, *pool);
+        int rep = 0;
+        double sortTime = best_seconds(reps, [&]() { copies[rep++].sortBySpeed(); });
+        report(name, "sort", sortTime, pool->size(), "hikers");
+        metrics[name + ".sort_ns_per_hiker"] = sortTime * 1e9 / pool->size();
+    }
+
+    struct EngineRun {
+        const char* phase;
+        CrossingTimeCalculator::Engine engine;
+        bool parallel; // Bridges split across one thread per core.
+        bool optimal;  // At most the greedy total, see dp_engine.h.
+    };
+    const EngineRun engines[] = {
+        {"solve-greedy", CrossingTimeCalculator::Engine::Greedy, false, false},
+        {"solve-incremental", CrossingTimeCalculator::Engine::Incremental, false, false},
+        {"solve-parallel", CrossingTimeCalculator::Engine::Incremental, true, false},
+        {"solve-profile", CrossingTimeCalculator::Engine::Profile, false, false},
+        {"solve-dp", CrossingTimeCalculator::Engine::DP, false, true},
+        {"solve-auto", CrossingTimeCalculator::Engine::Auto, false, false},
+    };
+    ThreadPool threadPool;
+    bool agree = true;
+    double expected = -1;
+    double fastestTime = -1;
+    for (auto& run : engines) {
+        if ((run.engine == CrossingTimeCalculator::Engine::Greedy ||
+            run.engine == CrossingTimeCalculator::Engine::DP) && !scenario.greedy) {
+            continue;
+        }
+        double total = 0;
+        double solveTime = best_seconds(reps, [&]() {
+            CrossingTimeCalculator calc(nullptr);
+            calc.setEngine(run.engine);
+            calc.setThreadPool(run.parallel ? &threadPool : nullptr);
+            total = calc.calcCrossingTime(bridges, origHikers, false);
+        });
+        report(name, run.phase, solveTime, bridges.size(), "bridges");
+        metrics[name + "." + run.phase + "_ns_per_bridge"] = solveTime * 1e9 / bridges.size();
+        if (run.engine == CrossingTimeCalculator::Engine::Auto) {
+            if (solveTime > fastestTime * kAutoSlack) {
+                std::cerr << name << ": " << run.phase << " takes " << solveTime * 1e3
+                    << " ms, the faster engine " << fastestTime * 1e3 << " ms" << std::endl;
+                agree = false;
+            }
+        }
+        else if ((run.engine == CrossingTimeCalculator::Engine::Greedy ||
+            run.engine == CrossingTimeCalculator::Engine::Incremental) && !run.parallel &&
+            (fastestTime < 0 || solveTime < fastestTime)) {
+            fastestTime = solveTime;
+        }
+        if (expected < 0) {
+            expected = total;
+        }
+        else if (run.optimal ? total > expected * (1 + 1e-6)
+            : std::fabs(total - expected) > 1e-6 * expected) {
+            std::cerr << name << ": " << run.phase << " total " << total
+                << " differs from " << expected << std::endl;
+            agree = false;
+        }
+    }
+    std::cout << std::left << std::setw(14) << name << std::setw(20) << "peak RSS"
+        << std::right << std::setw(10) << peak_rss_kb() << " KiB\n";
+    return agree;
+}
+
+bool read_metrics(const string& path, Metrics& metrics)
+{
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        string name;
+        double value;
+        if (line.empty() || line[0] == '#' || !(iss >> name >> value)) {
+            continue;
+        }
+        metrics[name] = value;
+    }
+    return true;
+}
+
+bool write_metrics(const string& path, const Metrics& metrics)
+{
+    std::ofstream out(path);
+    out << "# hiker_bench baseline: metric value, lower is better.\n"
+        << "# Machine specific, regenerate with `make bench-baseline`.\n";
+    for (auto& metric : metrics) {
+        out << metric.first << " " << std::setprecision(6) << metric.second << "\n";
+    }
+    return bool(out);
+}
+
+// Print every metric against the baseline; return the number of metrics
+// worse than the baseline by more than `tolerance` (a fraction).
+int compare_metrics(const Metrics& metrics, const Metrics& baseline, double tolerance)
+{
+    int regressions = 0;
+    std::cout << "\nAgainst baseline (tolerance " << tolerance * 100 << "%):\n";
+    for (auto& metric : metrics) {
+        auto found = baseline.find(metric.first);
+        std::cout << std::left << std::setw(44) << metric.first << std::right
+            << std::setprecision(1) << std::setw(12) << metric.second;
+        if (found == baseline.end() || found->second <= 0) {
+            std::cout << "  (no baseline)\n";
+            continue;
+        }
+        double change = metric.second / found->second - 1;
+        std::cout << std::setw(12) << found->second << std::showpos
+            << std::setw(9) << change * 100 << "%" << std::noshowpos;
+        if (change > tolerance) {
+            std::cout << "  REGRESSION";
+            ++regressions;
+        }
+        std::cout << "\n";
+    }
+    return regressions;
+}
+
+void print_usage()
+{
+    std::cerr << "Usage: hiker_bench [--baseline FILE] [--write-baseline FILE]"
+        " [--tolerance FRACTION] [--reps N] [--scenario NAME]\n"
+        "       hiker_bench --differential GROUPS [--seed N]\n"
+        "       hiker_bench --load CLIENTS [--requests N] [--socket PATH] [--seed N]"
+        << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    string baselinePath;
+    string writePath;
+    string only;
+    double tolerance = 0.5;
+    int reps = 5;
+    size_t differentialGroups = 0;
+    uint64_t seed = 1;
+    size_t loadClients = 0;
+    size_t loadRequests = 100000;
+    string socketPath;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (arg == "--baseline") {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "--write-baseline") {
+            writePath = argv[++i];
+        }
+        else if (arg == "--tolerance") {
+            tolerance = std::atof(argv[++i]);
+        }
+        else if (arg == "--reps") {
+            reps = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--scenario") {
+            only = argv[++i];
+        }
+        else if (arg == "--differential") {
+            differentialGroups = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--load") {
+            loadClients = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--requests") {
+            loadRequests = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--socket") {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--seed") {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (loadClients > 0) {
+        return run_load(socketPath, loadClients, loadRequests, seed) == 0 ? 0 : 1;
+    }
+    if (differentialGroups > 0) {
+        return run_differential(differentialGroups, seed) == 0 ? 0 : 1;
+    }
+
+    Metrics metrics;
+    bool agree = true;
+    for (auto& scenario : kScenarios) {
+        if (only.empty() || only == scenario.name) {
+            agree = run_scenario(scenario, reps, metrics) && agree;
+        }
+    }
+    if (metrics.empty()) {
+        std::cerr << "No scenario named " << only << std::endl;
+        return 1;
+    }
+    metrics["peak_rss_kb"] = peak_rss_kb();
+
+    int regressions = 0;
+    if (!baselinePath.empty()) {
+        Metrics baseline;
+        if (!read_metrics(baselinePath, baseline)) {
+            std::cerr << "Cannot read baseline " << baselinePath << std::endl;
+            return 1;
+        }
+        regressions = compare_metrics(metrics, baseline, tolerance);
+    }
+    if (!writePath.empty() && !write_metrics(writePath, metrics)) {
+        std::cerr << "Cannot write baseline " << writePath << std::endl;
+        return 1;
+    }
+    if (!agree) {
+        std::cerr << "Engines disagree or the default engine is slow" << std::endl;
+        return 1;
+    }
+    if (regressions > 0) {
+        std::cerr << regressions << " metric(s) regressed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "case_generator.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <random>
+
+
+namespace {
+
+// Speeds of the two fastest original hikers in threshold cases.
+const double kThresholdFastest = 100;
+const double kThresholdSecond = 50;
+
+class SpeedGenerator {
+public:
+    SpeedGenerator(SpeedDistribution distribution, uint64_t seed)
+        : distribution_(distribution), rng_(seed) {
+    }
+
+    double next() {
+        switch (distribution_) {
+        case SpeedDistribution::Uniform:
+            return std::uniform_real_distribution<double>(1, 100)(rng_);
+        case SpeedDistribution::Equal:
+            return 10;
+        case SpeedDistribution::Threshold: {
+            // Same as CrossingTimeCalculator::calcThresholdSpeed.
+            double threshold = 1 / (2 / kThresholdSecond - 1 / kThresholdFastest);
+            double offset = std::uniform_real_distribution<double>(-1e-9, 1e-9)(rng_);
+            return threshold * (1 + offset);
+        }
+        case SpeedDistribution::HeavyTailed: {
+            // Pareto with alpha 1.2 from 0.5, capped so times stay finite.
+            double u = std::uniform_real_distribution<double>(1e-12, 1)(rng_);
+            return std::min(0.5 / std::pow(u, 1 / 1.2), 1e6);
+        }
+        }
+        return 1;
+    }
+
+private:
+    SpeedDistribution distribution_;
+    std::mt19937_64 rng_;
+};
+
+void append_number(std::string& out, double value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void append_hiker(std::string& out, char prefix, size_t index, double speed)
+{
+    out += prefix;
+    out += std::to_string(index);
+    out += ' ';
+    append_number(out, speed);
+}
+
+} // namespace
+
+std::string generate_case(const CaseSpec& spec)
+{
+    SpeedGenerator speeds(spec.distribution, spec.seed);
+    std::uniform_real_distribution<double> length(10, 1000);
+    std::mt19937_64 lengthRng(spec.seed ^ 0x9e3779b97f4a7c15ull);
+
+    std::string out;
+    for (size_t i = 0; i < spec.hikerCount; ++i) {
+        double speed = speeds.next();
+        if (spec.distribution == SpeedDistribution::Threshold && i < 2) {
+            speed = i == 0 ? kThresholdFastest : kThresholdSecond;
+        }
+        if (i > 0) {
+            out += ',';
+        }
+        append_hiker(out, 'H', i, speed);
+    }
+    size_t additional = 0;
+    for (size_t b = 0; b < spec.bridgeCount; ++b) {
+        out += ';';
+        append_number(out, std::round(length(lengthRng)));
+        for (size_t i = 0; i < spec.arrivalsPerBridge; ++i) {
+            out += ',';
+            append_hiker(out, 'A', additional++, speeds.next());
+        }
+    }
+    return out;
+}
+
+const char* to_string(SpeedDistribution distribution)
+{
+    switch (distribution) {
+    case SpeedDistribution::Uniform:
+        return "uniform";
+    case SpeedDistribution::Equal:
+        return "equal";
+    case SpeedDistribution::Threshold:
+        return "threshold";
+    case SpeedDistribution::HeavyTailed:
+        return "heavy-tailed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Uniform: speeds spread over [1, 100).
+// Equal: every hiker at the same speed, so every sort is all ties.
+// Threshold: two fast original hikers, everyone else within a hair of the
+//   threshold speed they give, where the greedy plan switches between the
+//   fastest hiker helping alone and the two fastest crossing together.
+// HeavyTailed: Pareto speeds, mostly slow hikers and a few very fast ones.
+enum class SpeedDistribution { Uniform, Equal, Threshold, HeavyTailed };
+
+struct CaseSpec {
+    size_t hikerCount;        // Original hikers, at least 1.
+    size_t bridgeCount;       // At least 1.
+    size_t arrivalsPerBridge; // New hikers met at each bridge.
+    SpeedDistribution distribution;
+    uint64_t seed;
+};
+
+// A synthetic case in the string case format (see CaseParser), the same
+// for the same spec. Speeds are written so that they parse back exactly.
+std::string generate_case(const CaseSpec& spec);
+
+const char* to_string(SpeedDistribution distribution);
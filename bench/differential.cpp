@@ -0,0 +1,246 @@
+#include "differential.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "group_engine.h"
+#include "hiker_table.h"
+
+
+using std::vector;
+
+namespace {
+
+// Speeds of one group: original then additional hikers, each sorted.
+struct Group {
+    HikerColumns hikers;
+    HikerColumns additionalHikers;
+};
+
+const double kTolerance = 1e-9;
+const size_t kMaxReportedMismatches = 10;
+
+class GroupGenerator {
+public:
+    explicit GroupGenerator(uint64_t seed) : rng_(seed) {}
+
+    // Mostly small groups, where shape bugs hide, some up to 256 hikers.
+    void next(Group& group) {
+        int sizeClass = std::uniform_int_distribution<int>(0, 9)(rng_);
+        size_t size = sizeClass < 6 ? pick(1, 8) : sizeClass < 9 ? pick(9, 32) : pick(33, 256);
+        size_t origCount = pick(1, size);
+        generate(group, origCount, size - origCount,
+            std::uniform_int_distribution<int>(0, 3)(rng_));
+    }
+
+    // Uniform speeds over [1, 100).
+    void next(Group& group, size_t origCount, size_t additionalCount) {
+        generate(group, origCount, additionalCount, 0);
+    }
+
+private:
+    size_t pick(size_t low, size_t high) {
+        return std::uniform_int_distribution<size_t>(low, high)(rng_);
+    }
+
+    // 0: uniform; 1: a few integer speeds, many ties; 2: within a hair of
+    // the threshold speed of the two fastest original hikers; 3: Pareto,
+    // mostly slow and a few very fast.
+    void generate(Group& group, size_t origCount, size_t additionalCount, int distribution) {
+        vector<double> speeds(origCount + additionalCount);
+        for (auto& speed : speeds) {
+            speed = drawSpeed(distribution);
+        }
+        std::sort(speeds.begin(), speeds.begin() + origCount, std::greater<double>());
+        if (distribution == 2 && origCount >= 2) {
+            double threshold = 1 / (2 / speeds[1] - 1 / speeds[0]);
+            std::uniform_real_distribution<double> offset(-1e-12, 1e-12);
+            for (size_t i = 2; i < speeds.size(); ++i) {
+                speeds[i] = threshold * (1 + offset(rng_));
+            }
+            std::sort(speeds.begin(), speeds.begin() + origCount, std::greater<double>());
+        }
+        std::sort(speeds.begin() + origCount, speeds.end(), std::greater<double>());
+        fill(group.hikers, speeds.begin(), speeds.begin() + origCount);
+        fill(group.additionalHikers, speeds.begin() + origCount, speeds.end());
+    }
+
+    double drawSpeed(int distribution) {
+        switch (distribution) {
+        case 1:
+            return static_cast<double>(pick(1, 6)) * 10;
+        case 3: {
+            double u = std::uniform_real_distribution<double>(1e-12, 1)(rng_);
+            return std::min(0.5 / std::pow(u, 1 / 1.2), 1e6);
+        }
+        default:
+            return std::uniform_real_distribution<double>(1, 100)(rng_);
+        }
+    }
+
+    static void fill(HikerColumns& columns, vector<double>::const_iterator begin,
+        vector<double>::const_iterator end) {
+        columns.clear();
+        for (auto it = begin; it != end; ++it) {
+            columns.addHiker(*it, 1 / *it, 0);
+        }
+    }
+
+    std::mt19937_64 rng_;
+};
+
+void print_group(const Group& group)
+{
+    std::cerr << std::setprecision(17) << "  original:";
+    for (double speed : group.hikers.speeds) {
+        std::cerr << ' ' << speed;
+    }
+    std::cerr << "\n  additional:";
+    for (double speed : group.additionalHikers.speeds) {
+        std::cerr << ' ' << speed;
+    }
+    std::cerr << std::endl;
+}
+
+bool accepts(const GroupEngine& engine, const Group& group)
+{
+    return !engine.accepts || engine.accepts(group.hikers.size(), group.additionalHikers.size());
+}
+
+// Whether an additional hiker is faster than the fastest original hiker,
+// the only groups where the greedy plan can be beaten.
+bool has_faster_additional_hiker(const Group& group)
+{
+    return !group.additionalHikers.speeds.empty() &&
+        group.additionalHikers.speeds[0] > group.hikers.speeds[0];
+}
+
+void report_mismatch(size_t index, const GroupEngine& engine, double perFeetTime,
+    const GroupEngine& reference, double expected, const Group& group)
+{
+    std::cerr << "Group " << index << ": " << engine.name << " " << std::setprecision(17)
+        << perFeetTime << ", " << reference.name << " " << expected << "\n";
+    print_group(group);
+}
+
+size_t check_engines(size_t groupCount, uint64_t seed)
+{
+    const auto& engines = get_group_engines();
+    const GroupEngine& reference = engines[0];
+    GroupGenerator generator(seed);
+    Group group;
+    size_t mismatches = 0;
+    size_t improved = 0;
+    double maxImprovement = 0;
+    for (size_t i = 0; i < groupCount; ++i) {
+        generator.next(group);
+        HikerSpan hikers = group.hikers.getSpan();
+        HikerSpan additionalHikers = group.additionalHikers.getSpan();
+        double expected = reference.calcPerFeetTime(hikers, additionalHikers);
+        double tolerance = kTolerance * expected;
+        bool mismatch = false;
+        for (size_t e = 1; e < engines.size(); ++e) {
+            const GroupEngine& engine = engines[e];
+            if (!accepts(engine, group)) {
+                continue;
+            }
+            double perFeetTime = engine.calcPerFeetTime(hikers, additionalHikers);
+            bool agrees = std::fabs(perFeetTime - expected) <= tolerance;
+            if (engine.optimal && !agrees && perFeetTime < expected &&
+                has_faster_additional_hiker(group)) {
+                // A better plan than the greedy one, see dp_engine.h.
+                ++improved;
+                maxImprovement = std::max(maxImprovement, 1 - perFeetTime / expected);
+                agrees = true;
+            }
+            if (!agrees) {
+                if (mismatches < kMaxReportedMismatches) {
+                    report_mismatch(i, engine, perFeetTime, reference, expected, group);
+                }
+                mismatch = true;
+            }
+        }
+        mismatches += mismatch;
+    }
+    std::cout << "Checked " << groupCount << " groups against " << reference.name
+        << ": " << mismatches << " mismatch(es)\n"
+        << "Optimal engines beat " << reference.name << " on " << improved
+        << " group(s) with an additional hiker faster than the lead, by up to "
+        << std::setprecision(3) << maxImprovement * 100 << "%\n";
+    return mismatches;
+}
+
+void compare_throughput(uint64_t seed)
+{
+    struct Shape {
+        size_t origCount;
+        size_t additionalCount;
+    };
+    const Shape shapes[] = {{1, 3}, {2, 2}, {4, 4}, {2, 30}, {16, 16}, {64, 192}, {512, 512}};
+    const size_t kHikersPerRun = 1 << 18;
+    std::cout << "\nns per group (* fastest):\n" << std::left << std::setw(12) << "shape";
+    for (auto& engine : get_group_engines()) {
+        std::cout << std::right << std::setw(13) << engine.name;
+    }
+    std::cout << '\n';
+    GroupGenerator generator(seed);
+    for (auto& shape : shapes) {
+        size_t groupCount = std::max<size_t>(
+            16, kHikersPerRun / (shape.origCount + shape.additionalCount));
+        vector<Group> groups(groupCount);
+        for (auto& group : groups) {
+            generator.next(group, shape.origCount, shape.additionalCount);
+        }
+        vector<double> times;
+        for (auto& engine : get_group_engines()) {
+            if (!accepts(engine, groups[0])) {
+                times.push_back(-1);
+                continue;
+            }
+            double sum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (auto& group : groups) {
+                sum += engine.calcPerFeetTime(group.hikers.getSpan(),
+                    group.additionalHikers.getSpan());
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            // Keep the sum alive.
+            times.push_back(sum > 0 ? elapsed.count() * 1e9 / groupCount : 0);
+        }
+        size_t fastest = 0;
+        for (size_t e = 0; e < times.size(); ++e) {
+            if (times[e] >= 0 && (times[fastest] < 0 || times[e] < times[fastest])) {
+                fastest = e;
+            }
+        }
+        std::cout << std::left << std::setw(12)
+            << (std::to_string(shape.origCount) + "+" + std::to_string(shape.additionalCount));
+        for (size_t e = 0; e < times.size(); ++e) {
+            std::cout << std::right << std::setw(12);
+            if (times[e] < 0) {
+                std::cout << "-" << ' ';
+            }
+            else {
+                std::cout << std::fixed << std::setprecision(1) << times[e]
+                    << (e == fastest ? '*' : ' ');
+            }
+        }
+        std::cout << '\n';
+    }
+}
+
+} // namespace
+
+size_t run_differential(size_t groupCount, uint64_t seed)
+{
+    size_t mismatches = check_engines(groupCount, seed);
+    compare_throughput(seed);
+    return mismatches;
+}
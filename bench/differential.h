@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// Check every group engine (see group_engine.h) against the greedy engine, the
+// first in the list, on `groupCount` random groups of mixed shapes and speed
+// distributions, then time the engines on a few group shapes and mark the
+// fastest of each. An optimal engine such as dp may beat greedy when an
+// additional hiker is faster than the lead; that counts as agreeing. Return the
+// number of groups where an engine disagrees.
+size_t run_differential(size_t groupCount, uint64_t seed);
@@ -0,0 +1,146 @@
+#include "load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "binary_case.h"
+#include "cache.h"
+#include "calculator.h"
+#include "case_generator.h"
+#include "case_server.h"
+#include "fast_case_parser.h"
+
+
+using std::string;
+using std::vector;
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+const size_t kDistinctCases = 64;
+
+struct LoadCase {
+    string text;
+    string binary;
+    double totalTime;
+};
+
+// Small cases like the ones of an upstream service: a few hikers, a few
+// bridges.
+vector<LoadCase> make_cases(uint64_t seed)
+{
+    vector<LoadCase> cases(kDistinctCases);
+    string path = "/tmp/hiker_load_" + std::to_string(getpid()) + ".bin";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        CaseSpec spec{2 + i % 6, 1 + i % 8, i % 3, SpeedDistribution::Uniform, seed + i};
+        cases[i].text = generate_case(spec);
+        vector<Hiker> origHikers;
+        vector<Bridge> bridges;
+        CaseParseError error;
+        FastCaseParser().parse(cases[i].text, origHikers, bridges, error);
+        cases[i].totalTime = CrossingTimeCalculator(nullptr).calcCrossingTime(
+            bridges, origHikers, false);
+        write_binary_case(path, origHikers, bridges);
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf();
+        cases[i].binary = oss.str();
+    }
+    std::remove(path.c_str());
+    return cases;
+}
+
+double percentile(vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    auto nth = values.begin() + static_cast<size_t>(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+} // namespace
+
+size_t run_load(const string& socketPath, size_t clientCount, size_t requestCount,
+    uint64_t seed)
+{
+    vector<LoadCase> cases = make_cases(seed);
+    Cache cache;
+    std::unique_ptr<CaseServer> server;
+    string path = socketPath;
+    if (path.empty()) {
+        path = "/tmp/hiker_load_" + std::to_string(getpid()) + ".sock";
+        server.reset(new CaseServer(path, 0, &cache));
+    }
+    clientCount = std::max<size_t>(clientCount, 1);
+    vector<vector<double>> latencies(clientCount);
+    std::atomic<size_t> failures(0);
+    auto start = Clock::now();
+    vector<std::thread> clients;
+    for (size_t client = 0; client < clientCount; ++client) {
+        clients.emplace_back([&, client] {
+            size_t count = requestCount / clientCount +
+                (client < requestCount % clientCount ? 1 : 0);
+            try {
+                CaseClient connection(path);
+                for (size_t i = 0; i < count; ++i) {
+                    const LoadCase& loadCase = cases[(client + i * clientCount) % cases.size()];
+                    bool binary = i % 2 == 1;
+                    auto sent = Clock::now();
+                    double totalTime = connection.solve(
+                        binary ? CaseFormat::Binary : CaseFormat::String,
+                        binary ? loadCase.binary : loadCase.text);
+                    latencies[client].push_back(std::chrono::duration<double, std::micro>(
+                        Clock::now() - sent).count());
+                    if (std::fabs(totalTime - loadCase.totalTime) >
+                        1e-9 * (1 + loadCase.totalTime)) {
+                        ++failures;
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Client " << client << ": " << e.what() << std::endl;
+                failures += count - latencies[client].size();
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    vector<double> all;
+    for (auto& clientLatencies : latencies) {
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    std::cout << requestCount << " requests from " << clientCount << " client(s) in "
+        << seconds << " s: " << requestCount / seconds << " requests/s\n";
+    std::cout << "client p50 " << percentile(all, 0.5) << " us, p99 "
+        << percentile(all, 0.99) << " us\n";
+    if (server) {
+        server->stop();
+        LatencyStats stats = server->takeLatencyStats();
+        std::cout << "server p50 " << stats.p50Micros << " us, p99 " << stats.p99Micros
+            << " us, " << static_cast<double>(stats.requestCount) /
+            std::max<size_t>(stats.batchCount, 1) << " requests per batch\n";
+    }
+    if (failures > 0) {
+        std::cout << failures << " request(s) failed" << std::endl;
+    }
+    std::cout.flush();
+    return failures;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Send `requestCount` small cases, half as strings and half as binary
+// cases, over `clientCount` connections to the case server at
+// `socketPath`, or to one started in this process if it is empty (see
+// CaseServer). Print the throughput and the client side p50/p99 latency,
+// and the server side ones for a server in this process. Return the number
+// of requests that failed or got a wrong total time.
+size_t run_load(const std::string& socketPath, size_t clientCount, size_t requestCount,
+    uint64_t seed);
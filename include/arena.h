@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+// Monotonic allocator: memory is handed out from large chunks and only
+// released all at once, by reset() or the destructor, so a case parsed into
+// an arena costs a few allocations instead of one per name and node, and is
+// freed in one step. Not thread safe: an arena belongs to one case.
+class Arena {
+public:
+    static const size_t kFirstChunkSize = 4 << 10;
+    static const size_t kMaxChunkSize = 1 << 20;
+
+    Arena() : cursor_(nullptr), end_(nullptr), nextChunkSize_(kFirstChunkSize) {
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // `alignment` must be a power of two.
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor_)) & (alignment - 1);
+        if (cursor_ && size + padding <= static_cast<size_t>(end_ - cursor_)) {
+            char* result = cursor_ + padding;
+            cursor_ = result + size;
+            return result;
+        }
+        return allocateSlow(size, alignment);
+    }
+
+    // A copy of `str` that lives as long as the arena.
+    std::string_view copyString(std::string_view str);
+
+    // Release everything allocated so far. The first chunk is kept for the
+    // next case.
+    void reset();
+
+    // Bytes taken from the system.
+    size_t getCapacity() const;
+
+private:
+    void* allocateSlow(size_t size, size_t alignment);
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Chunk> chunks_;
+    char* cursor_;
+    char* end_;
+    size_t nextChunkSize_;
+};
+
+// Standard allocator over an Arena, for containers that live no longer than
+// the arena. Deallocation is a no-op.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit ArenaAllocator(Arena* arena) : arena_(arena) {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.getArena()) {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {
+    }
+
+    Arena* getArena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.getArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.getArena(); }
+
+private:
+    Arena* arena_;
+};
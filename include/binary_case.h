@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hiker_table.h"
+
+
+class Hiker;
+class Bridge;
+
+// Binary case file, in native byte order:
+//   header
+//   double   speeds[hikerCount]       original hikers sorted by speed in
+//   double   perFeetTimes[hikerCount]   descending order, then additional
+//                                       hikers in the order they are met
+//   BinaryBridge bridges[bridgeCount]
+//   uint32_t nameIds[hikerCount]
+//   uint32_t nameOffsets[nameCount + 1] into the name bytes
+//   char     names[nameBytes]
+// Every section is a plain array, so a mapped file is used in place.
+struct BinaryCaseHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t origHikerCount;
+    uint64_t additionalHikerCount;
+    uint64_t bridgeCount;
+    uint64_t nameCount;
+    uint64_t nameBytes;
+};
+
+// The new hikers met at a bridge are the additional hikers [newHikerBegin,
+// newHikerEnd), as in Bridge.
+struct BinaryBridge {
+    double length;
+    uint64_t newHikerBegin;
+    uint64_t newHikerEnd;
+};
+
+// Write a parsed case. Throws std::runtime_error if the file cannot be
+// written.
+void write_binary_case(const std::string& path,
+    const std::vector<Hiker>& origHikers, const std::vector<Bridge>& bridges);
+
+// A binary case file mapped read-only. Hikers are handed out as spans over
+// the mapping: loading checks the sections and the values in place, nothing
+// is parsed or allocated per hiker.
+class BinaryCase {
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is not a
+    // valid binary case of this version: damaged sections, or speeds and
+    // lengths the text parsers would reject ("Speed should > 0", ...).
+    explicit BinaryCase(const std::string& path);
+    // A binary case already in memory, e.g. received from a socket. `data`
+    // must be 8-byte aligned and outlive this. Throws std::runtime_error if
+    // it is not a valid binary case.
+    BinaryCase(const void* data, size_t size);
+    ~BinaryCase();
+
+    BinaryCase(const BinaryCase&) = delete;
+    BinaryCase& operator=(const BinaryCase&) = delete;
+
+    HikerSpan getOriginalHikers() const;
+    // Additional hikers [begin, end), in the order they are met.
+    HikerSpan getAdditionalHikers(size_t begin, size_t end) const;
+    size_t getAdditionalHikerCount() const { return header_->additionalHikerCount; }
+
+    size_t getBridgeCount() const { return header_->bridgeCount; }
+    const BinaryBridge& getBridge(size_t index) const { return bridges_[index]; }
+    HikerSpan getNewHikers(size_t bridge) const {
+        return getAdditionalHikers(bridges_[bridge].newHikerBegin, bridges_[bridge].newHikerEnd);
+    }
+
+    // Empty if the id is out of range.
+    std::string_view getName(uint32_t nameId) const;
+
+private:
+    // Point the sections into `data`; why it is not a valid case, or empty.
+    std::string load(const char* data, size_t size);
+
+    void* mapping_; // MAP_FAILED if the data is not mapped here.
+    size_t mappingSize_;
+    const BinaryCaseHeader* header_;
+    const double* speeds_;
+    const double* perFeetTimes_;
+    const BinaryBridge* bridges_;
+    const uint32_t* nameIds_;
+    const uint32_t* nameOffsets_;
+    const char* names_;
+};
@@ -1,19 +1,41 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include "hiker.h"
+#include "hiker_pool.h"
 
 
 class Bridge {
 public:
-    Bridge(double length, std::vector<Hiker> additionalHikers)
-        : additionalHikers_(additionalHikers), length_(length) {
+    explicit Bridge(double length) : newHikerBegin_(0), newHikerEnd_(0), length_(length) {
+    }
+
+    // The new hikers met at this bridge are [newHikerBegin, newHikerEnd) of
+    // the pool, and all the hikers before them were met at previous bridges.
+    Bridge(double length, std::shared_ptr<const HikerPool> pool,
+        size_t newHikerBegin, size_t newHikerEnd)
+        : pool_(pool), newHikerBegin_(newHikerBegin), newHikerEnd_(newHikerEnd),
+        length_(length) {
     }
 
     double getLength() const { return length_; }
-    size_t getAdditionalHikerCount() const { return additionalHikers_.size(); }
-    const std::vector<Hiker>& getAdditionalHikers() const { return additionalHikers_; }
+    size_t getAdditionalHikerCount() const { return newHikerEnd_; }
+    // All additional hikers met so far, sorted by speed. The list is built
+    // from the shared pool on each call.
+    std::vector<Hiker> getAdditionalHikers() const {
+        return pool_ ? pool_->getSortedHikers(newHikerEnd_) : std::vector<Hiker>();
+    }
+    // Additional hikers met at this bridge, in input order.
+    HikerSpan getNewHikers() const {
+        return pool_ ? pool_->getHikers(newHikerBegin_, newHikerEnd_)
+            : HikerSpan{nullptr, nullptr, nullptr, 0};
+    }
+    // The shared pool of additional hikers, may be null if there are none.
+    const HikerPool* getHikerPool() const { return pool_.get(); }
 
 private:
-    std::vector<Hiker> additionalHikers_;
+    std::shared_ptr<const HikerPool> pool_;
+    size_t newHikerBegin_;
+    size_t newHikerEnd_;
     double length_;
 };
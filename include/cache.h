@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+// Identifies a group of hikers by the multiset of the original hikers'
+// speeds and the multiset of the additional hikers' speeds (the two must be
+// told apart, as additional hikers cannot carry the torch back).
+struct GroupKey {
+    uint64_t origHash;
+    uint64_t additionalHash;
+
+    bool operator==(const GroupKey& other) const {
+        return origHash == other.origHash && additionalHash == other.additionalHash;
+    }
+};
+
+// Order independent hash of a group: the sum of a mixed hash of each speed,
+// so a hiker joining (or leaving) updates it in O(1) and the same group
+// gets the same key whatever order hikers are met in.
+class GroupFingerprint {
+public:
+    GroupFingerprint() : key_{0, 0} {}
+
+    void addOriginalHiker(double speed) { key_.origHash += hashSpeed(speed, kOrigSeed); }
+    void addAdditionalHiker(double speed) {
+        key_.additionalHash += hashSpeed(speed, kAdditionalSeed);
+    }
+    void removeOriginalHiker(double speed) { key_.origHash -= hashSpeed(speed, kOrigSeed); }
+    void removeAdditionalHiker(double speed) {
+        key_.additionalHash -= hashSpeed(speed, kAdditionalSeed);
+    }
+    // Add all hikers of another group.
+    void addGroup(const GroupFingerprint& other) {
+        key_.origHash += other.key_.origHash;
+        key_.additionalHash += other.key_.additionalHash;
+    }
+    const GroupKey& getKey() const { return key_; }
+
+    static uint64_t hashSpeed(double speed, uint64_t seed);
+
+private:
+    static const uint64_t kOrigSeed = 0x9e3779b97f4a7c15ull;
+    static const uint64_t kAdditionalSeed = 0xc2b2ae3d27d4eb4full;
+
+    GroupKey key_;
+};
+
+class PersistentCache;
+
+struct CacheStats {
+    uint64_t hits;
+    uint64_t persistentHits; // Misses in memory found in the persistent cache.
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+};
+
+// Per feet time of hiker groups, keyed by GroupKey. The table is flat and
+// fixed-size (bounded by the memory limit): a key may only live in the
+// kWays slots after its home slot, and when they are all taken one of them
+// is evicted with the CLOCK policy (recently hit slots get a second chance).
+// The table is split into shards with their own lock, so one cache can be
+// shared by worker threads. It is mapped zero filled, so only the pages of
+// the slots in use take memory: a run that meets a few groups does not pay
+// for the whole limit. An optional PersistentCache sits underneath: memory
+// misses are looked up there, and new results are written through.
+class Cache {
+public:
+    static const size_t kDefaultMemoryLimit = 64 << 20;
+    static const size_t kWays = 8;
+
+    // Throws std::bad_alloc if the table cannot be mapped.
+    explicit Cache(size_t memoryLimit = kDefaultMemoryLimit, size_t shardCount = 16);
+    ~Cache();
+
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+
+    // Return -1 if the group is not cached.
+    double getTime(const GroupKey& key);
+    void setTime(const GroupKey& key, double perFeetTime);
+    // Clear the table in memory (not the persistent cache).
+    void reset();
+
+    // Not owned, nullptr for none.
+    void setPersistentCache(PersistentCache* persistentCache) {
+        persistentCache_ = persistentCache;
+    }
+
+    size_t getCapacity() const { return shardCount_ * slotsPerShard_; }
+    CacheStats getStats() const;
+
+private:
+    // All zero bytes is an empty slot.
+    struct Slot {
+        GroupKey key;
+        double perFeetTime;
+        bool used;
+        bool referenced; // Hit since the clock hand last passed.
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        Slot* slots; // slotsPerShard_ slots of table_.
+        size_t clockHand;
+    };
+
+    Shard& getShard(const GroupKey& key, size_t& home);
+    void insert(Shard& shard, size_t home, const GroupKey& key, double perFeetTime);
+
+    size_t shardCount_;
+    size_t slotsPerShard_; // Power of two.
+    Slot* table_;
+    size_t tableBytes_;
+    std::unique_ptr<Shard[]> shards_;
+    PersistentCache* persistentCache_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> persistentHits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> insertions_;
+    std::atomic<uint64_t> evictions_;
+};
@@ -1,23 +1,118 @@
 #pragma once
+#include <functional>
 #include <vector>
 #include "hiker.h"
 #include "bridge.h"
+#include "hiker_group.h"
+#include "hiker_profile.h"
+#include "hiker_table.h"
+#include "speed_sort.h"
 
 
+class BinaryCase;
 class Cache;
+struct GroupKey;
+class CrossingPlan;
+class ThreadPool;
 
 class CrossingTimeCalculator {
 public:
-    CrossingTimeCalculator(Cache* cache) : timeCache_(cache) {
+    // Greedy: run the greedy plan over all hikers at each bridge; this is the
+    //   only engine that records the plan, so it is used while recording.
+    // Incremental: keep the group of hikers between bridges and only add the
+    //   new hikers of each bridge, O(k log n) per bridge with k new hikers.
+    //   Small groups run the unrolled kernels of small_group.h instead.
+    // Profile: keep prefix sums over the merged speed order of the group,
+    //   merge the new hikers of each bridge in, and find the per feet time
+    //   with binary searches and lookups.
+    // DP: keep the additional hikers sorted, merge the new hikers of each
+    //   bridge in and run the dynamic program of dp_engine.h, O(n) per
+    //   bridge with new hikers. It does not use the threshold speed, so it
+    //   checks the others; it finds a lower time than they do when an
+    //   additional hiker is faster than the fastest original hiker, so its
+    //   results are cached under keys the other engines do not use.
+    // Auto (the default): Greedy or Incremental, see chooseEngine.
+    enum class Engine { Greedy, Incremental, Profile, DP, Auto };
+
+    CrossingTimeCalculator(Cache* cache) : timeCache_(cache),
+        engine_(Engine::Auto), plan_(nullptr), threadPool_(nullptr) {
     }
 
+    void setEngine(Engine engine) { engine_ = engine; }
+    Engine getEngine() const { return engine_; }
+
+    // The engine Auto runs on a case of `hikerCount` hikers in all and
+    // `bridgeCount` bridges. The greedy engine goes over every hiker at each
+    // bridge, the incremental one pays for a tree insertion per hiker once,
+    // so Greedy runs up to kGreedyBridgesPerLevel * log2(hikerCount)
+    // bridges (large groups over few bridges), Incremental beyond.
+    static Engine chooseEngine(size_t hikerCount, size_t bridgeCount);
+    static const size_t kGreedyBridgesPerLevel = 16;
+
+    // Record the plan of each calcCrossingTime call into `plan` (cleared
+    // first); nullptr stops recording.
+    void setPlan(CrossingPlan* plan) { plan_ = plan; }
+
+    // Split the bridges of one case across the threads of `pool` (nullptr
+    // for one thread). Only the Incremental engine (set, or picked by Auto)
+    // runs in parallel, and only for cases of at least
+    // kMinParallelChunkBridges * 2 bridges. The
+    // total is summed per chunk, then pairwise in chunk order; the chunks
+    // only depend on the bridge count, so the total is the same whatever
+    // the thread count (it may differ in the last bits from one thread).
+    void setThreadPool(ThreadPool* pool) { threadPool_ = pool; }
+
+    static const size_t kMinParallelChunkBridges = 256;
+    static const size_t kMaxParallelChunks = 64;
+
+    // Verbose records the plan and prints it as text with one write at the
+    // end, see PlanWriter.
+    //
+    // Without a plan, the engines work in buffers kept by the calculator,
+    // so once a case has been solved, solving cases up to its size
+    // allocates nothing (the parallel path excepted, see setThreadPool).
     double calcCrossingTime(const std::vector<Bridge>& bridges,
         const std::vector<Hiker>& origHikers, bool verbose);
 
+    // Solve a mapped binary case straight from its spans. The greedy engine
+    // needs every group sorted, so it (and Auto) runs as Incremental here;
+    // no plan is recorded.
+    double calcCrossingTime(const BinaryCase& binaryCase);
+
+    // Same plan as calcPerFeetTime on Hiker vectors, but reading only the
+    // speed and per feet time columns. Steps are recorded into `plan` if
+    // given, hiker ids are rows of `hikers` then rows of `additionalHikers`.
+    // Without a plan, small groups run the unrolled kernel of their size
+    // (see small_group.h).
+    double calcPerFeetTime(const HikerSpan& hikers,
+        const HikerSpan& additionalHikers, CrossingPlan* plan = nullptr);
+    // The general greedy plan, whatever the group size.
+    double calcPerFeetTimeGeneral(const HikerSpan& hikers,
+        const HikerSpan& additionalHikers);
+
 protected:
+    // Output policies of the greedy plan. NoPlan records nothing, so every
+    // recording branch of the plan loops is compiled out; PlanRecorder
+    // records the steps into a CrossingPlan.
+    struct NoPlan {
+        static const bool kRecords = false;
+        void beginBridge(double, size_t) {}
+        void setCacheHit() {}
+        void addStep(uint32_t, uint32_t, uint32_t) {}
+    };
+    struct PlanRecorder {
+        static const bool kRecords = true;
+        CrossingPlan* plan;
+        void beginBridge(double length, size_t hikerCount);
+        void setCacheHit();
+        void addStep(uint32_t first, uint32_t second, uint32_t returner);
+    };
+
+    // Hiker ids in the plan are `firstId` plus the index in `hikers`.
+    template <typename Output>
     double calcPerFeetTimeHikerHelpsHikers(const Hiker& hikerLead,
-        const std::vector<Hiker>& hikers,
-        int startIndex, int targetIndex, bool targetIndexShouldReturn, bool verbose);
+        const std::vector<Hiker>& hikers, uint32_t firstId,
+        int startIndex, int targetIndex, bool targetIndexShouldReturn, Output& output);
 
     double calcThresholdSpeed(double fastest, double second);
 
@@ -30,9 +125,76 @@ protected:
         const std::vector<Hiker>& additionalHikers,
         int& index, int& additionalIndex);
 
+    // Hiker ids in the plan are indexes in `hikers`, then in `additionalHikers`.
     double calcPerFeetTime(const std::vector<Hiker>& hikers,
-        const std::vector<Hiker>& additionalHikers, bool verbose);
+        const std::vector<Hiker>& additionalHikers, CrossingPlan* plan);
+    template <typename Output>
+    double calcPerFeetTimeWith(const std::vector<Hiker>& hikers,
+        const std::vector<Hiker>& additionalHikers, Output& output);
+
+    template <typename Output>
+    double calcPerFeetTimeHikerHelpsHikers(double leadPerFeetTime,
+        const HikerSpan& hikers, uint32_t firstId,
+        int startIndex, int targetIndex, bool targetIndexShouldReturn, Output& output);
+
+    // The general greedy plan on columns, whatever the group size.
+    template <typename Output>
+    double calcPerFeetTimeWith(const HikerSpan& hikers,
+        const HikerSpan& additionalHikers, Output& output);
+
+    size_t countSpeedSlowerThan(const HikerSpan& hikers, double thresholdSpeed);
+
+    // Return the plan id of the slowest hiker.
+    uint32_t removeSlowestHiker(const HikerSpan& hikers,
+        const HikerSpan& additionalHikers,
+        int& index, int& additionalIndex, double& perFeetTime);
+
+    double calcCrossingTimeGreedy(const std::vector<Bridge>& bridges,
+        const std::vector<Hiker>& origHikers, CrossingPlan* plan);
+    template <typename Output>
+    double calcCrossingTimeGreedyWith(const std::vector<Bridge>& bridges,
+        const std::vector<Hiker>& origHikers, Output& output);
+
+    // The cached per feet time of the group `key`, else calc() (then cached).
+    template <typename Calc>
+    double calcCachedPerFeetTime(const GroupKey& key, Calc calc);
+
+    // Set the new hikers of bridge `index`, in input order, and return its
+    // length.
+    typedef std::function<double(size_t index, HikerSpan& newHikers)> BridgeSource;
+
+    // The original hikers must be sorted by speed in descending order.
+    double calcCrossingTimeIncremental(const HikerSpan& origHikers,
+        size_t bridgeCount, const BridgeSource& getBridge);
+
+    double calcCrossingTimeProfile(const HikerSpan& origHikers,
+        size_t bridgeCount, const BridgeSource& getBridge);
+
+    double calcCrossingTimeDP(const HikerSpan& origHikers,
+        size_t bridgeCount, const BridgeSource& getBridge);
+
+    // The Incremental engine on chunks of bridges, see setThreadPool.
+    // getBridge is called from several threads at once.
+    double calcCrossingTimeParallel(const HikerSpan& origHikers,
+        size_t bridgeCount, const BridgeSource& getBridge);
+    // Whether calcCrossingTimeParallel should be used for `engine`.
+    bool runsInParallel(Engine engine, size_t bridgeCount) const;
 
 private:
+    // Buffers of the engines, kept from one case to the next.
+    struct Workspace {
+        HikerColumns origHikers;
+        HikerColumns additionalHikers;
+        HikerColumns newHikers;
+        HikerColumns scratch;
+        HikerGroup group;
+        HikerProfile profile;
+        SpeedSortBuffers sortBuffers;
+    };
+
+    Workspace workspace_;
     Cache* timeCache_;
+    Engine engine_;
+    CrossingPlan* plan_;
+    ThreadPool* threadPool_;
 };
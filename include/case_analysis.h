@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bridge.h"
+#include "hiker.h"
+
+
+// One change to an analyzed case, see CaseAnalysis::evaluate. Hikers are
+// CaseAnalysis hiker indexes; `bridge` is where a hiker is met, or
+// CaseAnalysis::kOriginal for an original hiker.
+struct CaseChange {
+    enum class Kind { RemoveHiker, AddHiker, ChangeSpeed, MoveArrival };
+
+    Kind kind;
+    size_t hiker;
+    double speed;
+    size_t bridge;
+
+    static CaseChange removeHiker(size_t hiker) {
+        return CaseChange{Kind::RemoveHiker, hiker, 0.0, 0};
+    }
+    static CaseChange addHiker(double speed, size_t bridge) {
+        return CaseChange{Kind::AddHiker, 0, speed, bridge};
+    }
+    static CaseChange changeSpeed(size_t hiker, double speed) {
+        return CaseChange{Kind::ChangeSpeed, hiker, speed, 0};
+    }
+    static CaseChange moveArrival(size_t hiker, size_t bridge) {
+        return CaseChange{Kind::MoveArrival, hiker, 0.0, bridge};
+    }
+};
+
+// A solved case prepared for what-if queries. The bridges are cut into
+// segments that share one group (a segment starts at each bridge where
+// hikers join), and the time of the case up to each bridge is kept. A
+// change only alters the groups from the first bridge where it applies, so
+// a query starts from the kept time there and, for each segment after,
+// applies the change to the group, solves it in O(log n) and undoes it.
+// A batch of queries shares one walk over the segments.
+class CaseAnalysis {
+public:
+    static const size_t kOriginal = SIZE_MAX;
+
+    struct HikerInfo {
+        std::string name;
+        double speed;
+        size_t arrival; // Bridge where the hiker is met, or kOriginal.
+    };
+
+    // The case as given to CrossingTimeCalculator::calcCrossingTime.
+    CaseAnalysis(const std::vector<Bridge>& bridges, const std::vector<Hiker>& origHikers);
+
+    // Original hikers first, then additional hikers in the order they are met.
+    size_t getHikerCount() const { return hikers_.size(); }
+    const HikerInfo& getHiker(size_t hiker) const { return hikers_[hiker]; }
+    // The first hiker named `name`, or getHikerCount() if none.
+    size_t findHiker(std::string_view name) const;
+    size_t getBridgeCount() const { return lengthSums_.size() - 1; }
+
+    // Same as the Incremental engine without a cache; -1 if there is no
+    // original hiker.
+    double getTotalTime() const { return totalTime_; }
+
+    // Total time of the case with each change applied alone, -1 where a
+    // change leaves no original hiker. Throws std::invalid_argument for an
+    // unknown hiker or bridge, or a speed that is not > 0.
+    std::vector<double> evaluate(const std::vector<CaseChange>& changes) const;
+
+private:
+    // The group gains (or loses) a hiker from bridge `begin` on.
+    struct Delta {
+        size_t begin;
+        double speed;
+        bool original;
+        bool add;
+    };
+    struct Query {
+        Delta deltas[2];
+        size_t deltaCount;
+        size_t begin; // First bridge where a delta applies.
+    };
+    // Bridges [begin, end) cross with the same group; `arrivals` are the
+    // hikers who join at `begin`.
+    struct Segment {
+        size_t begin;
+        size_t end;
+        std::vector<uint32_t> arrivals;
+    };
+
+    Query makeQuery(const CaseChange& change) const;
+
+    std::vector<HikerInfo> hikers_;
+    std::vector<Segment> segments_;
+    std::vector<double> lengthSums_; // lengthSums_[i]: bridges [0, i).
+    std::vector<double> timeSums_;   // timeSums_[i]: time of bridges [0, i).
+    double totalTime_;
+};
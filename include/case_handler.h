@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+
+
+class Hiker;
+
+// Receives a case piece by piece while it is parsed, so it can be solved
+// without keeping the bridges. Parsers call onOriginalHikers once, then
+// onBridge for each bridge in order; `newHikers` only holds the hikers who
+// join at that bridge and is reused after the call returns.
+class CaseHandler {
+public:
+    virtual ~CaseHandler() {}
+
+    virtual void onOriginalHikers(const std::vector<Hiker>& origHikers) = 0;
+    virtual void onBridge(double length, const std::vector<Hiker>& newHikers) = 0;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+
+class Cache;
+class CrossingTimeCalculator;
+
+enum class CaseFormat : uint32_t { String = 0, Binary = 1 };
+
+// Frames on the socket, in native byte order:
+//   request:  uint32_t size, uint32_t format (CaseFormat), `size` bytes of
+//             the case
+//   response: uint32_t size, uint32_t status, `size` bytes: the total time
+//             as a double if status is 0, otherwise the error message
+// A connection may send requests without waiting for the responses; they
+// are answered in order.
+const size_t kMaxCaseRequestBytes = 64 << 20;
+// Requests solved together at most.
+const size_t kMaxCaseBatch = 256;
+// Requests a connection may have unanswered, or answered but not yet
+// written to it, before the server stops reading from it.
+const size_t kMaxCaseBacklog = 1024;
+// Bytes of such requests (then of their responses) a connection may hold;
+// a larger request is read only once the connection holds nothing else.
+const size_t kMaxCaseBacklogBytes = kMaxCaseRequestBytes;
+// Connections served at once; more wait in the listen queue.
+const size_t kMaxCaseConnections = 64;
+
+// Latency from a request read to its response ready to write, in
+// microseconds. Requests are counted before their responses are written, so
+// a client that got its answer finds it in the stats; the write itself is
+// not part of the latency.
+struct LatencyStats {
+    size_t requestCount;
+    size_t batchCount;
+    double p50Micros;
+    double p99Micros;
+};
+
+// Solves cases sent over a Unix domain socket. A thread per connection
+// reads requests into one queue; a batch thread takes whatever is queued
+// (up to kMaxCaseBatch) and solves it on the thread pool, one calculator
+// per worker and one shared cache, then hands the responses to a writer
+// thread per connection, so a client that stops reading only holds up its
+// own connection. Batches grow only while the previous one is being solved,
+// so a lone request does not wait for company. With the limits above, the
+// server holds at most kMaxCaseConnections * kMaxCaseBacklogBytes of
+// requests and responses.
+class CaseServer {
+public:
+    // Listen at `socketPath`, replacing a stale socket file there. 0
+    // threads: one per hardware thread. Throws std::runtime_error if the
+    // socket cannot be set up.
+    CaseServer(const std::string& socketPath, size_t threadCount = 0, Cache* cache = nullptr);
+    ~CaseServer();
+
+    CaseServer(const CaseServer&) = delete;
+    CaseServer& operator=(const CaseServer&) = delete;
+
+    // Close the socket and the connections and wait for the threads.
+    // Queued requests are still answered, unless a client does not read
+    // its responses within a second.
+    void stop();
+
+    // Stats of the requests answered since the last call.
+    LatencyStats takeLatencyStats();
+
+private:
+    struct Connection;
+    struct Request;
+
+    struct ConnectionThreads {
+        Connection* connection; // Null once the writer is done.
+        std::thread reader;
+        std::thread writer;
+    };
+
+    void acceptLoop();
+    void readLoop(std::shared_ptr<Connection> connection);
+    void writeLoop(std::shared_ptr<Connection> connection, ConnectionThreads* threads);
+    void batchLoop();
+    void solve(Request& request, CrossingTimeCalculator& calc);
+
+    std::string socketPath_;
+    Cache* cache_;
+    ThreadPool pool_;
+    int listenFd_;
+
+    std::mutex mutex_;
+    std::condition_variable queueReady_;
+    std::condition_variable threadsDone_;
+    std::deque<std::unique_ptr<Request>> queue_;
+    // Joined by the accept thread once their writer is done, or by stop().
+    std::list<ConnectionThreads> connections_;
+    size_t readerCount_;
+    size_t writerCount_;
+    bool stopping_;
+
+    std::mutex statsMutex_;
+    std::vector<double> latencies_;
+    size_t batchCount_;
+
+    std::thread acceptThread_;
+    std::thread batchThread_;
+};
+
+// A connection to a CaseServer, one request at a time.
+class CaseClient {
+public:
+    // Throws std::runtime_error if the server cannot be reached.
+    explicit CaseClient(const std::string& socketPath);
+    ~CaseClient();
+
+    CaseClient(const CaseClient&) = delete;
+    CaseClient& operator=(const CaseClient&) = delete;
+
+    // The total time of the case. Throws std::invalid_argument with the
+    // server's message if the case is rejected, std::runtime_error if the
+    // connection fails.
+    double solve(CaseFormat format, std::string_view data);
+
+private:
+    int fd_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// One step of a crossing plan: one or two hikers cross, then one hiker
+// (maybe) carries the torch back. Hiker ids index the roster of the bridge:
+// the original hikers first, then the accumulated additional hikers, both
+// sorted by speed in descending order.
+struct PlanStep {
+    static const uint32_t kNone = 0xffffffffu;
+
+    uint32_t first;
+    uint32_t second;   // kNone if `first` crosses alone.
+    uint32_t returner; // kNone if nobody returns.
+};
+
+// The steps of one bridge are [stepBegin, stepEnd) of CrossingPlan's steps.
+struct BridgePlan {
+    double length;
+    size_t hikerCount;
+    size_t stepBegin;
+    size_t stepEnd;
+    bool cacheHit;     // The per feet time came from the cache, no steps.
+};
+
+// Compact record of the crossing plans of all the bridges of a case, with
+// no names and no I/O. PlanWriter renders it.
+class CrossingPlan {
+public:
+    void beginBridge(double length, size_t hikerCount) {
+        bridges_.push_back(BridgePlan{length, hikerCount, steps_.size(), steps_.size(), false});
+    }
+    void setCacheHit() { bridges_.back().cacheHit = true; }
+    void addStep(uint32_t first, uint32_t second, uint32_t returner) {
+        steps_.push_back(PlanStep{first, second, returner});
+        bridges_.back().stepEnd = steps_.size();
+    }
+    void clear() {
+        bridges_.clear();
+        steps_.clear();
+    }
+
+    const std::vector<BridgePlan>& getBridges() const { return bridges_; }
+    const std::vector<PlanStep>& getSteps() const { return steps_; }
+
+private:
+    std::vector<BridgePlan> bridges_;
+    std::vector<PlanStep> steps_;
+};
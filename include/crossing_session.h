@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cache.h"
+#include "hiker_group.h"
+
+
+// A live route, built one event at a time: hikers join and leave, and
+// bridges are crossed in route order. Only the sorted group (HikerGroup) and
+// the running total are kept, so each event costs O(log n) in the group
+// size instead of solving the whole route again.
+class CrossingSession {
+public:
+    explicit CrossingSession(Cache* cache = nullptr) : cache_(cache) {
+        reset();
+    }
+
+    // Hikers added before the first bridge are original hikers, who can
+    // carry the torch back; later ones are additional hikers met at the next
+    // bridge, as in the case formats. Throws std::invalid_argument if the
+    // speed is not > 0.
+    void addHiker(std::string_view name, double speed);
+    // The last added hiker named `name` leaves, from the next bridge on.
+    // Return false if there is no such hiker.
+    bool removeHiker(std::string_view name);
+    // Cross a bridge with the current group and return its crossing time.
+    // Throws std::invalid_argument if the length is not > 0 or if no
+    // original hiker is left.
+    double addBridge(double length);
+
+    // Forget the route, to start another one.
+    void reset();
+
+    size_t getHikerCount() const { return group_.getHikerCount(); }
+    size_t getBridgeCount() const { return bridgeCount_; }
+    double getTotalTime() const { return totalTime_; }
+
+private:
+    struct Member {
+        double speed;
+        bool original;
+    };
+
+    void updatePerFeetTime();
+
+    HikerGroup group_;
+    GroupFingerprint fingerprint_;
+    Cache* cache_;
+    std::unordered_map<std::string, std::vector<Member>> members_; // By name, latest last.
+    double perFeetTime_;
+    bool groupChanged_; // perFeetTime_ is stale.
+    double totalTime_;
+    size_t bridgeCount_;
+};
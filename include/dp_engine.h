@@ -0,0 +1,20 @@
+#pragma once
+#include "hiker_table.h"
+
+
+// The classic O(n) dynamic program for the bridge and torch problem, with
+// this project's rule that additional hikers cannot carry the torch back.
+// The fastest original hiker (A) and the second (B) bring the torch back;
+// everyone else, from the slowest, either crosses with A (A returns), or
+// crosses with the next slowest while A and B shuttle the torch (A and B
+// cross, A returns, the two cross, B returns). dp[i], the best time for the
+// i slowest, is the cheaper of the two moves; at the end A and B cross.
+//
+// It makes no use of the threshold speed, so it checks the greedy plan of
+// CrossingTimeCalculator independently. The two agree unless an additional
+// hiker is faster than A: A sets the pace when helping such a hiker across,
+// so two of them crossing together can be cheaper even above the threshold
+// speed, which the greedy plan never pairs. The dp result is then lower.
+// Both spans sorted by speed in descending order, at least one original
+// hiker; O(n), no allocation.
+double calc_dp_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers);
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+
+class Hiker;
+class Bridge;
+class HikerPool;
+
+// Where and why a case could not be parsed. `position` is the offset in the
+// case string of the first character that could not be accepted.
+struct CaseParseError {
+    size_t position;
+    const char* message;
+};
+
+// Parser of the string case format (see CaseParser) in one pass over the
+// input: tokens are views of the case string, numbers are read with
+// std::from_chars, and additional hiker names go straight into the shared
+// pool, so no token is copied. Errors are returned with their position
+// instead of thrown.
+//
+// Stricter than CaseParser: a hiker is exactly "name speed" and a number
+// must fill its item, where CaseParser ignores extra words and trailing
+// characters.
+class FastCaseParser {
+public:
+    // Return false and set `error` if the case is malformed; the output is
+    // then incomplete.
+    bool parse(std::string_view strCase,
+        std::vector<Hiker>& origHikers, std::vector<Bridge>& bridges,
+        CaseParseError& error);
+
+protected:
+    // The parse functions read from pos_ and leave it after what they read.
+    bool parseHiker(std::string_view& name, double& speed);
+    bool parseNumber(double& value);
+    bool fail(size_t position, const char* message);
+
+private:
+    std::string_view input_;
+    size_t pos_ = 0;
+    CaseParseError* error_ = nullptr;
+};
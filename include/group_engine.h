@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "hiker_table.h"
+
+
+// The ways to find the per feet time of one group, behind one signature so
+// that they can be checked against each other and timed on the same groups
+// (see hiker_bench --differential). A new engine only needs an entry in
+// get_group_engines().
+struct GroupEngine {
+    const char* name;
+    // Both spans sorted by speed in descending order, at least one
+    // original hiker.
+    double (*calcPerFeetTime)(const HikerSpan& hikers, const HikerSpan& additionalHikers);
+    // Groups the engine handles; nullptr for all.
+    bool (*accepts)(size_t hikerCount, size_t additionalHikerCount);
+    // The best plan under the rules (dp), rather than the greedy plan.
+    bool optimal;
+};
+
+// The greedy engine first: the other engines of the greedy plan must give
+// its result, and optimal engines at most its result.
+const std::vector<GroupEngine>& get_group_engines();
+
+// nullptr if there is no engine of that name.
+const GroupEngine* find_group_engine(const char* name);
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class Cache;
+class Hiker;
+struct GroupKey;
+
+// Speed-sorted multiset of hikers. Every node of the underlying treap keeps
+// the hiker count and the per feet time sums (total, and split by even/odd
+// position inside the subtree) of its subtree, so that rank, prefix sum and
+// alternating sum queries cost O(log n).
+class SpeedTree {
+public:
+    SpeedTree();
+
+    void insert(double speed);
+    // Remove one hiker with exactly this speed. Return false if none.
+    bool erase(double speed);
+    void clear();
+    // Replace the hikers with `count` speeds sorted in descending order, in
+    // O(n) instead of n inserts.
+    void build(const double* speeds, size_t count);
+
+    size_t size() const { return nodes_[root_].count; }
+
+    // Speed of the hiker at the given rank (0 is the fastest).
+    double select(size_t rank) const;
+    size_t countSpeedSlowerThan(double speed) const;
+    size_t countSpeedFasterThan(double speed) const;
+
+    // Sum of per feet time of the hikers whose rank is in [begin, end).
+    double sumPerFeetTime(size_t begin, size_t end) const;
+    // Same as above, but only the ranks with the same parity as `parity`.
+    double sumPerFeetTime(size_t begin, size_t end, size_t parity) const;
+
+private:
+    struct Node {
+        double speed;
+        double perFeetTime;
+        double sum;
+        double evenSum; // Sum of per feet time at even positions in subtree.
+        double oddSum;
+        uint32_t priority;
+        uint32_t count;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    uint32_t newNode(double speed);
+    void update(uint32_t node);
+    // Split into hikers faster than `speed` (or as fast as, if `equalGoesLeft`)
+    // and the rest.
+    void split(uint32_t node, double speed, bool equalGoesLeft,
+        uint32_t& left, uint32_t& right);
+    uint32_t merge(uint32_t left, uint32_t right);
+    // Balanced subtree of speeds [begin, end) at `depth`; deeper nodes get
+    // lower priorities so the heap order holds.
+    uint32_t buildSubtree(const double* speeds, size_t begin, size_t end, uint32_t depth);
+    // Sum of the subtree whose first hiker has rank `offset`. A negative
+    // parity means all ranks.
+    double subtreeSum(uint32_t node, size_t offset, int parity) const;
+    double rangeSum(uint32_t node, size_t offset,
+        size_t begin, size_t end, int parity) const;
+
+    // Node 0 is the empty sentinel, so that children never need a null check.
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeNodes_;
+    uint32_t root_;
+    uint32_t seed_;
+};
+
+// The group of hikers crossing a bridge: the original hikers plus the
+// accumulated additional hikers. Hikers can join (and leave) one at a time,
+// and the per feet time of the greedy plan used by CrossingTimeCalculator is
+// evaluated in closed form from the tree sums:
+//   pairs * (fastest + 2*second) + (odd positions sum of the 2*pairs slowest)
+//   + (rest - 3 + fasterThanLead) * fastest + (sum of the rest)
+//   - (sum of the hikers faster than the lead)
+// where "rest" is the number of hikers that are not in a slowest pair.
+class HikerGroup {
+public:
+    HikerGroup() = default;
+    explicit HikerGroup(const std::vector<Hiker>& origHikers);
+
+    void addOriginalHiker(double speed);
+    void addAdditionalHiker(double speed);
+    bool removeOriginalHiker(double speed);
+    bool removeAdditionalHiker(double speed);
+    void clear();
+    // Replace the group, both arrays sorted by speed in descending order;
+    // `speeds` holds all hikers, original ones included.
+    void build(const double* origSpeeds, size_t origCount,
+        const double* speeds, size_t count);
+
+    size_t getHikerCount() const { return hikers_.size(); }
+    size_t getOriginalHikerCount() const { return origHikers_.size(); }
+
+    // Same result as CrossingTimeCalculator::calcPerFeetTime for this group
+    // up to rounding, in O(log n). Return -1 if there are no original hikers.
+    double calcPerFeetTime() const;
+    // Same, looked up in `cache` under `key` first and stored there if
+    // missing; nullptr for no cache. The key must identify this group (see
+    // GroupFingerprint).
+    double calcPerFeetTime(Cache* cache, const GroupKey& key) const;
+
+private:
+    SpeedTree hikers_;     // All hikers, original and additional.
+    SpeedTree origHikers_; // Only to find the fastest and second original.
+};
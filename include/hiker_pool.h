@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "hiker.h"
+#include "hiker_table.h"
+
+
+// Append-only storage of the additional hikers of a case, in the order they
+// are met. All the bridges of a case share one pool, and each bridge only
+// keeps the range of its own new hikers; the accumulated additional hikers
+// of a bridge are the first hikers of the pool up to the end of that range.
+// Memory is then linear in the input size instead of bridges x hikers.
+class HikerPool {
+public:
+    size_t addHiker(const Hiker& hiker) { return hikers_.addHiker(hiker); }
+    size_t addHiker(std::string_view name, double speed) {
+        return hikers_.addHiker(name, speed);
+    }
+    void reserve(size_t count) { hikers_.reserve(count); }
+    size_t size() const { return hikers_.size(); }
+    Hiker getHiker(size_t index) const { return hikers_.getHiker(index); }
+    HikerSpan getHikers(size_t begin, size_t end) const { return hikers_.getSpan(begin, end); }
+    const HikerTable& getTable() const { return hikers_; }
+
+    // Sort all hikers by speed once parsing is done, so that sorted views do
+    // not need sorting again. The pool stays in input order.
+    void sortBySpeed();
+
+    // The first `count` hikers of the pool, sorted by speed in descending
+    // order (ties in input order).
+    std::vector<Hiker> getSortedHikers(size_t count) const;
+    // Same, as columns whose name ids refer to getTable().getNames(). Does
+    // not allocate once the pool is sorted and `sorted` is large enough.
+    void getSortedHikers(size_t count, HikerColumns& sorted) const;
+
+private:
+    void getSortedIndexes(size_t count, std::vector<uint32_t>& indexes) const;
+
+    HikerTable hikers_;
+    std::vector<uint32_t> sortedIndexes_; // Valid if it covers all hikers.
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "hiker_table.h"
+
+
+// Prefix sums over the merged speed order of a group of hikers (original and
+// additional). The greedy plan's per feet time is a slowest pair count times
+// a constant, plus an alternating sum over the slowest hikers and a sum over
+// a contiguous range of the others, so once the profile is built it is found
+// with two binary searches and a few lookups.
+class HikerProfile {
+public:
+    // Both spans sorted by speed in descending order.
+    void build(const HikerSpan& origHikers, const HikerSpan& additionalHikers);
+    // Merge more additional hikers (sorted by speed) into the profile, in
+    // place from the slowest end. Only the hikers slower than the fastest
+    // new one move and get their prefix sums computed again, so hikers
+    // slower than everyone are cheap to add.
+    void addHikers(const HikerSpan& additionalHikers);
+
+    size_t getHikerCount() const { return speeds_.size(); }
+
+    // Same result as CrossingTimeCalculator::calcPerFeetTime for this group,
+    // up to rounding. Return -1 if there are no original hikers.
+    double calcPerFeetTime() const;
+
+private:
+    void updatePrefixSums(size_t begin);
+    // Sum of per feet time of ranks [begin, end).
+    double sumPerFeetTime(size_t begin, size_t end) const;
+    // Same, but only the ranks with the same parity as `parity`.
+    double sumPerFeetTime(size_t begin, size_t end, size_t parity) const;
+
+    size_t origHikerCount_ = 0;
+    double fastestSpeed_ = 0.0;
+    double fastestPerFeetTime_ = 0.0;
+    double secondSpeed_ = 0.0;
+    double secondPerFeetTime_ = 0.0;
+
+    std::vector<double> speeds_;       // Merged, in descending order.
+    std::vector<double> perFeetTimes_;
+    std::vector<double> prefixSums_;   // prefixSums_[i]: sum of ranks [0, i).
+    // paritySums_[p][i]: sum of ranks in [0, i) with parity p.
+    std::vector<double> paritySums_[2];
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "arena.h"
+
+
+class Hiker;
+struct SpeedSortBuffers;
+
+// Hiker names, each stored once and looked up by id. The names and the
+// nodes of the lookup table live in the table's own Arena, so interning
+// does not allocate per name, and everything is freed at once with the
+// table.
+class NameTable {
+public:
+    NameTable();
+    NameTable(const NameTable& other);
+    NameTable& operator=(const NameTable& other);
+    NameTable(NameTable&& other) noexcept;
+    NameTable& operator=(NameTable&& other) noexcept;
+
+    uint32_t intern(std::string_view name);
+    // Valid as long as the table.
+    std::string_view getName(uint32_t id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    typedef std::unordered_map<std::string_view, uint32_t, std::hash<std::string_view>,
+        std::equal_to<std::string_view>,
+        ArenaAllocator<std::pair<const std::string_view, uint32_t>>> IdMap;
+
+    // Held by pointer so that it does not move with the table.
+    std::unique_ptr<Arena> arena_;
+    IdMap ids_;                          // Views of names in arena_.
+    std::vector<std::string_view> names_; // By id.
+};
+
+// View over a range of rows of a HikerTable. The calculation hot path only
+// reads the contiguous speed and per feet time columns.
+struct HikerSpan {
+    const double* speeds;
+    const double* perFeetTimes;
+    const uint32_t* nameIds;
+    size_t size;
+};
+
+// Hiker columns whose name ids refer to the NameTable of another store,
+// e.g. a sorted copy of some rows of a HikerTable.
+struct HikerColumns {
+    std::vector<double> speeds;       // in feet/min
+    std::vector<double> perFeetTimes;
+    std::vector<uint32_t> nameIds;
+
+    size_t size() const { return speeds.size(); }
+    void addHiker(double speed, double perFeetTime, uint32_t nameId);
+    void reserve(size_t count);
+    void clear();
+    // Sort rows by speed in descending order (ties keep their order).
+    void sortBySpeed();
+    // Same, without allocating once `buffers` and `scratch` (which gets the
+    // old rows) have grown to the row count.
+    void sortBySpeed(SpeedSortBuffers& buffers, HikerColumns& scratch);
+    HikerSpan getSpan() const { return getSpan(0, size()); }
+    HikerSpan getSpan(size_t begin, size_t end) const;
+};
+
+// Structure-of-arrays store of hikers: one column per field, and names
+// interned in a NameTable so that a row only holds the name id.
+class HikerTable {
+public:
+    size_t addHiker(std::string_view name, double speed);
+    size_t addHiker(const Hiker& hiker);
+    void reserve(size_t count) { columns_.reserve(count); }
+    void clear();
+
+    size_t size() const { return columns_.size(); }
+    double getSpeed(size_t row) const { return columns_.speeds[row]; }
+    double getPerFeetTime(size_t row) const { return columns_.perFeetTimes[row]; }
+    uint32_t getNameId(size_t row) const { return columns_.nameIds[row]; }
+    std::string_view getName(size_t row) const { return names_.getName(getNameId(row)); }
+    Hiker getHiker(size_t row) const;
+    const HikerColumns& getColumns() const { return columns_; }
+    const NameTable& getNames() const { return names_; }
+
+    HikerSpan getSpan() const { return columns_.getSpan(); }
+    HikerSpan getSpan(size_t begin, size_t end) const { return columns_.getSpan(begin, end); }
+
+    void sortBySpeed() { columns_.sortBySpeed(); }
+
+private:
+    HikerColumns columns_;
+    NameTable names_;
+};
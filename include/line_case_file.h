@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+class Cache;
+class ThreadPool;
+
+// Chunks of a line case file are about this size; a chunk is the unit of
+// work of solve_line_cases.
+const size_t kLineChunkBytes = 1 << 20;
+
+// A text file of string cases (see CaseParser), one case per line, mapped
+// read-only so that cases are parsed in place.
+class LineCaseFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit LineCaseFile(const std::string& path);
+    ~LineCaseFile();
+
+    LineCaseFile(const LineCaseFile&) = delete;
+    LineCaseFile& operator=(const LineCaseFile&) = delete;
+
+    std::string_view getData() const {
+        return std::string_view(static_cast<const char*>(mapping_), size_);
+    }
+
+    // Offsets of chunks of about `chunkSize` bytes, from 0 to the file size.
+    // Each chunk but the last ends just after a newline.
+    std::vector<size_t> splitChunks(size_t chunkSize = kLineChunkBytes) const;
+
+private:
+    void* mapping_;
+    size_t size_;
+};
+
+struct LineCaseSummary {
+    size_t caseCount;
+    size_t errorCount;
+};
+
+// Parse and solve every line of `input` on the pool, a chunk per task, and
+// write one line per input line, in input order: the total time (shortest
+// form that reads back the same double), "Parse case error at P: message"
+// with P the offset in the line, or an empty line for an empty line. A
+// trailing '\r' is ignored. Chunks are solved a few per worker at a time,
+// so memory does not grow with the file. `cache` may be nullptr.
+LineCaseSummary solve_line_cases(const LineCaseFile& input, std::ostream& output,
+    ThreadPool& pool, Cache* cache);
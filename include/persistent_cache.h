@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cache.h"
+
+
+// Per feet time of hiker groups in a memory-mapped file, so results survive
+// across runs and can be shared by processes on the same host.
+//
+// The file is a fixed-size header and a fixed-size open-addressing table.
+// Entries are only ever added: a writer claims an empty slot with a
+// compare-and-swap on its tag, fills in the key, and publishes the per feet
+// time last. A slot whose per feet time is still 0 is not ready and reads as
+// a miss, so a process crashing mid-insert only wastes that slot. When all
+// the probed slots of a key are taken the result is simply not stored.
+class PersistentCache {
+public:
+    static const size_t kDefaultSlotCount = 1 << 20;
+    static const size_t kProbeLimit = 16;
+
+    // Open `path`, creating it with `slotCount` slots (rounded up to a power
+    // of two) if it does not exist. An existing file keeps its own size.
+    // Throws std::runtime_error if the file cannot be opened, mapped, or is
+    // not a cache file.
+    explicit PersistentCache(const std::string& path,
+        size_t slotCount = kDefaultSlotCount);
+    ~PersistentCache();
+
+    PersistentCache(const PersistentCache&) = delete;
+    PersistentCache& operator=(const PersistentCache&) = delete;
+
+    // Return -1 if the group is not stored.
+    double getTime(const GroupKey& key) const;
+    // Return false if there is no room left for the key.
+    bool setTime(const GroupKey& key, double perFeetTime);
+
+    size_t getSlotCount() const { return slotCount_; }
+
+private:
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t slotSize;
+        uint64_t slotCount;
+    };
+
+    // All fields are accessed with atomic builtins, the mapping is shared.
+    struct Slot {
+        uint64_t tag;        // 0: empty.
+        uint64_t origHash;
+        uint64_t additionalHash;
+        uint64_t perFeetTimeBits; // 0: not ready.
+    };
+
+    static uint64_t getTag(const GroupKey& key);
+
+    int fd_;
+    void* mapping_;
+    size_t mappingSize_;
+    Slot* slots_;
+    size_t slotCount_; // Power of two.
+};
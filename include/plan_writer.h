@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+
+
+class Hiker;
+class Bridge;
+class CrossingPlan;
+
+enum class PlanFormat { Text, JSON, CSV };
+
+// Parse "text", "json" or "csv". Return false if unknown.
+bool parse_plan_format(const std::string& str, PlanFormat& format);
+
+// Renders a CrossingPlan into a string, so that the whole report can be
+// written with one call instead of one flushed write per step. Names are
+// only looked up here.
+class PlanWriter {
+public:
+    explicit PlanWriter(PlanFormat format) : format_(format) {
+    }
+
+    // Append the plan of these bridges to `out`. The original hikers and the
+    // bridges must be the ones the plan was recorded for.
+    void write(const CrossingPlan& plan, const std::vector<Hiker>& origHikers,
+        const std::vector<Bridge>& bridges, std::string& out) const;
+
+protected:
+    // Text: the same lines the calculator used to print.
+    void writeText(const CrossingPlan& plan, const std::vector<Hiker>& origHikers,
+        const std::vector<Bridge>& bridges, std::string& out) const;
+
+    // JSON: {"bridges":[{"length":..,"hikers":..,"cacheHit":..,
+    //   "steps":[{"cross":["A","B"],"returns":"A"},...]},...]}
+    void writeJSON(const CrossingPlan& plan, const std::vector<Hiker>& origHikers,
+        const std::vector<Bridge>& bridges, std::string& out) const;
+
+    // CSV: bridge,length,step,first,second,returner (cache hits have no step).
+    void writeCSV(const CrossingPlan& plan, const std::vector<Hiker>& origHikers,
+        const std::vector<Bridge>& bridges, std::string& out) const;
+
+private:
+    PlanFormat format_;
+};
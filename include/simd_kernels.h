@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+
+// Vectorized kernels for the calculator's inner loops. The best level the
+// CPU supports is picked at run time; the scalar level is the reference.
+// The sums and counts run in the Greedy engine when no plan is recorded,
+// which is what the default engine runs for large groups over few bridges
+// (see CrossingTimeCalculator::chooseEngine); the Incremental and Profile
+// engines read the same sums from their tree or prefix sums instead.
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+// Best level supported by this CPU (and this build).
+SimdLevel get_simd_level();
+
+const char* simd_level_name(SimdLevel level);
+
+// Sum of fmax(leadPerFeetTime, perFeetTimes[i]) over the range, i.e. the
+// crossing times when the lead hiker helps each hiker across.
+// The vector levels add in a different order than the scalar level. All
+// terms are positive, so both results are within (count-1) * 2^-53 * sum of
+// the exact sum, and thus within (count-1) * 2^-52 * sum of each other.
+double sum_max_per_feet_time(const double* perFeetTimes, size_t count,
+    double leadPerFeetTime);
+double sum_max_per_feet_time(const double* perFeetTimes, size_t count,
+    double leadPerFeetTime, SimdLevel level);
+
+// Number of speeds < thresholdSpeed. Exact at every level; speeds need not
+// be sorted.
+size_t count_speed_slower_than(const double* speeds, size_t count,
+    double thresholdSpeed);
+size_t count_speed_slower_than(const double* speeds, size_t count,
+    double thresholdSpeed, SimdLevel level);
+
+// Offset of the first `byte` in data[0, size), or size if there is none.
+// Scans 32 bytes per step from the AVX2 level on (AVX512 uses the AVX2
+// kernel: byte compares need AVX-512BW).
+size_t find_byte(const char* data, size_t size, char byte);
+size_t find_byte(const char* data, size_t size, char byte, SimdLevel level);
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include "hiker_table.h"
+
+
+// Most groups have only a few hikers. For those, the greedy plan has a
+// fully unrolled kernel per group size: the speeds are merged into a fixed
+// size array, then the slow count, the pairs and the rest are summed with
+// no data dependent loop. The Greedy and Incremental engines of
+// CrossingTimeCalculator run them on small groups; the general plan stays
+// the fallback for bigger groups and for recording plans.
+const size_t kMaxSmallGroupSize = 8;
+
+// Groups that calc_small_group_per_feet_time handles: at least two original
+// hikers (one alone helps everyone, which is not worth a kernel) and at
+// most kMaxSmallGroupSize hikers in all.
+inline bool is_small_group(size_t hikerCount, size_t additionalHikerCount)
+{
+    return hikerCount >= 2 && hikerCount + additionalHikerCount <= kMaxSmallGroupSize;
+}
+
+// Per feet time of the greedy plan of a small group, both spans sorted by
+// speed in descending order. Same as CrossingTimeCalculator::calcPerFeetTime
+// up to rounding, the terms are added in another order.
+double calc_small_group_per_feet_time(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers);
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Index sorts by speed, so that only 4 byte row numbers move instead of
+// hikers (and their names). Big arrays are sorted with an LSD radix sort on
+// the IEEE-754 bits of the speeds, which is linear in the count; small ones
+// with a merge sort of insertion sorted runs of 16, which merges through
+// SpeedSortBuffers::scratchRows where std::stable_sort would allocate a
+// buffer on every call.
+const size_t kRadixSortMinCount = 256;
+
+struct SpeedSortKey {
+    uint64_t key;
+    uint32_t row;
+};
+
+// Scratch memory of the sorts. Sorting again with the same buffers does not
+// allocate once they have grown to the row count. `rows` is left to the
+// caller, e.g. for the rows to sort.
+struct SpeedSortBuffers {
+    std::vector<uint32_t> rows;
+    std::vector<uint32_t> scratchRows;
+    std::vector<SpeedSortKey> keys;
+    std::vector<SpeedSortKey> scratchKeys;
+    std::vector<size_t> histograms;
+};
+
+// Sort `rows` (indexes into `speeds`) by speed in descending order. Stable:
+// rows with the same speed keep their order.
+void sort_rows_by_speed(const double* speeds, std::vector<uint32_t>& rows);
+void sort_rows_by_speed(const double* speeds, std::vector<uint32_t>& rows,
+    SpeedSortBuffers& buffers);
+
+// Same, always with the radix sort; for tests and benchmarks.
+void radix_sort_rows_by_speed(const double* speeds, std::vector<uint32_t>& rows);
+void radix_sort_rows_by_speed(const double* speeds, std::vector<uint32_t>& rows,
+    SpeedSortBuffers& buffers);
@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+struct CacheStats;
+
+// Phases can nest: the parsers sort the hikers they read, so that sort time
+// is also part of the parse time. Solve time is the sum of the per bridge
+// spans.
+enum class StatPhase { Parse, Sort, Solve, Report };
+const size_t kStatPhaseCount = 4;
+
+// HikersProcessed counts the group size of each bridge solved, SlowPairs the
+// pairs of slow hikers the greedy plan lets cross together.
+enum class StatCounter { Bridges, HikersProcessed, SlowPairs };
+const size_t kStatCounterCount = 3;
+
+// Process wide timers and counters, safe to update from several threads.
+// Nothing is recorded until setEnabled(true), and the HIKER_STATS_* hooks
+// below are compiled out unless HIKER_STATS is defined (make STATS=1, the
+// default).
+class Stats {
+public:
+    static Stats& instance() { return instance_; }
+    // Whether the hooks were compiled in.
+    static bool isCompiledIn();
+    // Monotonic time in nanoseconds, never 0.
+    static uint64_t now();
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    // Also keep one trace event per span, see writeTrace.
+    void setTracing(bool tracing) { tracing_.store(tracing, std::memory_order_relaxed); }
+    bool isTracing() const { return tracing_.load(std::memory_order_relaxed); }
+
+    void add(StatCounter counter, uint64_t count) {
+        counts_[static_cast<size_t>(counter)].fetch_add(count, std::memory_order_relaxed);
+    }
+    // `name` and `arg` (if >= 0) label the trace event, `name` must be a
+    // literal.
+    void addSpan(StatPhase phase, const char* name, int64_t arg,
+        uint64_t begin, uint64_t end);
+
+    uint64_t getCount(StatCounter counter) const {
+        return counts_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    uint64_t getTime(StatPhase phase) const {
+        return times_[static_cast<size_t>(phase)].load(std::memory_order_relaxed);
+    }
+    uint64_t getSpanCount(StatPhase phase) const {
+        return spans_[static_cast<size_t>(phase)].load(std::memory_order_relaxed);
+    }
+    void reset();
+
+    // {"enabled":..,"phases":{"parse":{"seconds":..,"spans":..},..},
+    //  "counters":{..},"cache":{..}}; the cache section only if given.
+    void writeJSON(std::ostream& out, const CacheStats* cacheStats) const;
+    // Chrome trace event format, for chrome://tracing or Perfetto.
+    void writeTrace(std::ostream& out) const;
+
+private:
+    struct TraceEvent {
+        const char* name;
+        int64_t arg;
+        uint64_t begin;
+        uint64_t duration;
+        uint32_t thread;
+    };
+
+    static Stats instance_;
+
+    std::atomic<bool> enabled_{false};
+    std::atomic<bool> tracing_{false};
+    std::atomic<uint64_t> counts_[kStatCounterCount] = {};
+    std::atomic<uint64_t> times_[kStatPhaseCount] = {};
+    std::atomic<uint64_t> spans_[kStatPhaseCount] = {};
+    mutable std::mutex traceMutex_;
+    std::vector<TraceEvent> trace_;
+};
+
+// Times its scope into a phase if stats are enabled.
+class StatTimer {
+public:
+    explicit StatTimer(StatPhase phase, const char* name = nullptr, int64_t arg = -1)
+        : phase_(phase), name_(name), arg_(arg),
+        begin_(Stats::instance().isEnabled() ? Stats::now() : 0) {
+    }
+    ~StatTimer() {
+        if (begin_) {
+            Stats::instance().addSpan(phase_, name_, arg_, begin_, Stats::now());
+        }
+    }
+
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+
+private:
+    StatPhase phase_;
+    const char* name_;
+    int64_t arg_;
+    uint64_t begin_;
+};
+
+#ifdef HIKER_STATS
+#define HIKER_STATS_CONCAT_(a, b) a##b
+#define HIKER_STATS_CONCAT(a, b) HIKER_STATS_CONCAT_(a, b)
+// Time the rest of the scope.
+#define HIKER_STATS_TIMER(phase) \
+    StatTimer HIKER_STATS_CONCAT(statTimer, __LINE__)(phase)
+// Time the rest of the scope as the solve of bridge `index`.
+#define HIKER_STATS_BRIDGE(index) \
+    StatTimer HIKER_STATS_CONCAT(statTimer, __LINE__)(StatPhase::Solve, "bridge", \
+        static_cast<int64_t>(index))
+#define HIKER_STATS_ADD(counter, count) \
+    do { \
+        if (Stats::instance().isEnabled()) { \
+            Stats::instance().add(counter, count); \
+        } \
+    } while (0)
+#else
+#define HIKER_STATS_TIMER(phase) static_cast<void>(0)
+#define HIKER_STATS_BRIDGE(index) static_cast<void>(0)
+#define HIKER_STATS_ADD(counter, count) static_cast<void>(0)
+#endif
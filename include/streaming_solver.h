@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "cache.h"
+#include "case_handler.h"
+#include "hiker_group.h"
+
+
+class Hiker;
+
+// Solves a case while it is parsed: each bridge is solved as soon as it
+// arrives, reported to the listener, and then forgotten. Only the group's
+// speeds are kept (see HikerGroup), so memory does not grow with the number
+// of bridges.
+class StreamingSolver : public CaseHandler {
+public:
+    // Called after each bridge with its index, length and the total time so
+    // far.
+    typedef std::function<void(size_t bridge, double length, double totalTime)> Listener;
+
+    explicit StreamingSolver(Cache* cache = nullptr) : cache_(cache) {
+        reset();
+    }
+
+    void setListener(Listener listener) { listener_ = listener; }
+
+    // Throws std::invalid_argument if there are no original hikers.
+    void onOriginalHikers(const std::vector<Hiker>& origHikers) override;
+    void onBridge(double length, const std::vector<Hiker>& newHikers) override;
+
+    // Forget the case, to solve another one.
+    void reset();
+
+    size_t getBridgeCount() const { return bridgeCount_; }
+    double getTotalTime() const { return totalTime_; }
+
+private:
+    void updatePerFeetTime();
+
+    HikerGroup group_;
+    GroupFingerprint fingerprint_;
+    Cache* cache_;
+    Listener listener_;
+    double perFeetTime_;
+    double totalTime_;
+    size_t bridgeCount_;
+};
@@ -1,10 +1,13 @@
 #pragma once
+#include <istream>
 #include <string>
 #include <vector>
 
 
 class Hiker;
 class Bridge;
+class HikerPool;
+class CaseHandler;
 
 class CaseParser {
 public:
@@ -15,6 +18,11 @@ public:
     void parse(const std::string& strCase,
         std::vector<Hiker>& origHikers, std::vector<Bridge>& bridges);
 
+    // Same format read from a stream, one bridge at a time: the handler gets
+    // each bridge as soon as it is read, and no bridge is kept. Whitespace
+    // around the items (a trailing newline) is ignored.
+    void parse(std::istream& in, CaseHandler& handler);
+
 protected:
     // Hiker: name speed
     Hiker parseHiker(const std::string& strHiker);
@@ -23,6 +31,8 @@ protected:
     void parseHikers(const std::string& strHikers, std::vector<Hiker>& hikers);
 
     // Bridge: length, additionalHiker1 speed1, ..., additionalHiker-n speed-n (hikers are optional)
+    void parseBridge(const std::string& strBridge,
+        double& length, HikerPool& additionalHikers);
     void parseBridge(const std::string& strBridge,
         double& length, std::vector<Hiker>& additionalHikers);
 };
@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// A fixed set of worker threads running parallel loops over task indexes.
+// Each worker owns a range of the indexes and takes tasks from its front;
+// a worker whose range is empty steals the back half of another worker's
+// range, so uneven tasks (a few large cases among many small ones) still
+// keep all the workers busy.
+class ThreadPool {
+public:
+    // 0 threads: one per hardware thread.
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getThreadCount() const { return threadCount_; }
+
+    // Run task(index, worker) for each index in [0, count) and return when
+    // all are done. `worker` is in [0, getThreadCount()), and a worker runs
+    // one task at a time, so per worker state can be indexed by it. The
+    // calling thread is worker 0. The first exception thrown by a task is
+    // rethrown here after the other tasks are done.
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& task);
+
+private:
+    struct Range {
+        std::mutex mutex;
+        size_t begin;
+        size_t end;
+    };
+
+    void workerLoop(size_t worker);
+    void runTasks(size_t worker);
+    bool popTask(size_t worker, size_t& index);
+    bool stealTasks(size_t worker);
+
+    size_t threadCount_;
+    std::unique_ptr<Range[]> ranges_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::condition_variable allDone_;
+    const std::function<void(size_t, size_t)>* task_;
+    uint64_t generation_;   // Incremented for each parallelFor.
+    size_t busyWorkers_;
+    bool stopping_;
+    std::exception_ptr error_;
+};
+
+// Most threads a --threads option may ask for.
+const size_t kMaxThreadCount = 1024;
+
+// Parse a thread count for ThreadPool: a decimal number in [0,
+// kMaxThreadCount], 0 for one per hardware thread. Return false if `str` is
+// anything else.
+bool parse_thread_count(const std::string& str, size_t& threadCount);
@@ -19,4 +19,6 @@ std::vector<std::string> split(const std::string& str, char delimiter);
 
 double parse_double(const std::string& str);
 
+bool ends_with(const std::string& str, const std::string& suffix);
+
 bool double_equal(double lhs, double rhs);
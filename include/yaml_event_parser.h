@@ -0,0 +1,38 @@
+#pragma once
+#include <iostream>
+#include <istream>
+#include <string>
+#include <vector>
+
+
+class Hiker;
+class Bridge;
+class CaseHandler;
+
+// Reads a YAML case (same layout as YAMLCaseParser) from yaml-cpp's event
+// stream instead of a YAML::Node tree: hikers and bridges are filled in as
+// their events arrive, and only the bridge being read is held. Errors are
+// the ones YAMLCaseParser gives on YAML::LoadFile of the same document.
+//
+// Aliases are only supported for scalars. If the bridges come before the
+// hikers in the document, the bridges are kept until the hikers are read.
+class YAMLEventCaseParser {
+public:
+    // Hiker errors are logged to `log` before they are thrown, as
+    // YAMLCaseParser logs them to std::cerr.
+    explicit YAMLEventCaseParser(std::ostream& log = std::cerr) : log_(log) {}
+
+    void parse(std::istream& in,
+        std::vector<Hiker>& origHikers, std::vector<Bridge>& bridges);
+    // The handler gets the original hikers, then each bridge as soon as its
+    // mapping ends.
+    void parse(std::istream& in, CaseHandler& handler);
+
+    // Same as above on a file. Throws YAML::BadFile if it cannot be opened.
+    void parseFile(const std::string& filename,
+        std::vector<Hiker>& origHikers, std::vector<Bridge>& bridges);
+    void parseFile(const std::string& filename, CaseHandler& handler);
+
+private:
+    std::ostream& log_;
+};
@@ -8,6 +8,8 @@ namespace YAML {
 
 class Hiker;
 class Bridge;
+class HikerPool;
+class CaseHandler;
 
 // YAML example:
 // hikers:
@@ -33,11 +35,17 @@ public:
     void parse(const YAML::Node& node,
         std::vector<Hiker>& origHikers, std::vector<Bridge>& bridges);
 
+    // Hand the case to `handler` bridge by bridge instead of building the
+    // bridges.
+    void parse(const YAML::Node& node, CaseHandler& handler);
+
 protected:
     Hiker parseHiker(const YAML::Node& node);
 
     void parseHikers(const YAML::Node& node, std::vector<Hiker>& hikers);
 
+    void parseBridge(const YAML::Node& node,
+        double& length, HikerPool& additionalHikers);
     void parseBridge(const YAML::Node& node,
         double& length, std::vector<Hiker>& additionalHikers);
 };
@@ -0,0 +1,45 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+const size_t Arena::kFirstChunkSize;
+const size_t Arena::kMaxChunkSize;
+
+std::string_view Arena::copyString(std::string_view str) {
+    if (str.empty()) {
+        return std::string_view();
+    }
+    char* data = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(data, str.data(), str.size());
+    return std::string_view(data, str.size());
+}
+
+void Arena::reset() {
+    if (chunks_.empty()) {
+        return;
+    }
+    chunks_.resize(1);
+    cursor_ = chunks_[0].data.get();
+    end_ = cursor_ + chunks_[0].size;
+    nextChunkSize_ = std::min(chunks_[0].size * 2, kMaxChunkSize);
+}
+
+size_t Arena::getCapacity() const {
+    size_t capacity = 0;
+    for (auto& chunk : chunks_) {
+        capacity += chunk.size;
+    }
+    return capacity;
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment) {
+    // Chunks double up to kMaxChunkSize; a bigger request gets its own.
+    size_t chunkSize = std::max(nextChunkSize_, size + alignment);
+    nextChunkSize_ = std::min(nextChunkSize_ * 2, kMaxChunkSize);
+    chunks_.push_back(Chunk{std::unique_ptr<char[]>(new char[chunkSize]), chunkSize});
+    cursor_ = chunks_.back().data.get();
+    end_ = cursor_ + chunkSize;
+    return allocate(size, alignment);
+}
@@ -0,0 +1,210 @@
+#include "binary_case.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "stats.h"
+
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const uint64_t kMagic = 0x0045534143524b48ull; // "HKRCASE"
+const uint32_t kVersion = 1;
+
+string format_error()
+{
+    return "Not a binary case of version " + std::to_string(kVersion);
+}
+
+template <typename T>
+void write_array(std::ofstream& out, const T* data, size_t count)
+{
+    out.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+}
+
+} // namespace
+
+void write_binary_case(const string& path,
+    const vector<Hiker>& origHikers, const vector<Bridge>& bridges)
+{
+    // Original hikers then all the additional hikers, with names interned
+    // again so that the file only holds the names it uses.
+    HikerTable hikers;
+    for (auto& hiker : origHikers) {
+        hikers.addHiker(hiker);
+    }
+    vector<BinaryBridge> binaryBridges;
+    binaryBridges.reserve(bridges.size());
+    for (auto& bridge : bridges) {
+        size_t begin = hikers.size() - origHikers.size();
+        auto newHikers = bridge.getNewHikers();
+        for (size_t i = 0; i < newHikers.size; ++i) {
+            hikers.addHiker(bridge.getHikerPool()->getTable().getNames().getName(
+                newHikers.nameIds[i]), newHikers.speeds[i]);
+        }
+        binaryBridges.push_back(BinaryBridge{bridge.getLength(), begin,
+            hikers.size() - origHikers.size()});
+    }
+    auto& names = hikers.getNames();
+    vector<uint32_t> nameOffsets(1, 0);
+    for (size_t id = 0; id < names.size(); ++id) {
+        nameOffsets.push_back(static_cast<uint32_t>(nameOffsets.back() + names.getName(id).size()));
+    }
+    BinaryCaseHeader header{kMagic, kVersion, static_cast<uint32_t>(origHikers.size()),
+        hikers.size() - origHikers.size(), bridges.size(), names.size(), nameOffsets.back()};
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    auto& columns = hikers.getColumns();
+    write_array(out, &header, 1);
+    write_array(out, columns.speeds.data(), columns.size());
+    write_array(out, columns.perFeetTimes.data(), columns.size());
+    write_array(out, binaryBridges.data(), binaryBridges.size());
+    write_array(out, columns.nameIds.data(), columns.size());
+    write_array(out, nameOffsets.data(), nameOffsets.size());
+    for (size_t id = 0; id < names.size(); ++id) {
+        write_array(out, names.getName(id).data(), names.getName(id).size());
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write binary case: " + path);
+    }
+}
+
+BinaryCase::BinaryCase(const string& path) : mapping_(MAP_FAILED), mappingSize_(0) {
+    HIKER_STATS_TIMER(StatPhase::Parse);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        string error = strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("Cannot open binary case: " + path + " (" + error + ")");
+    }
+    mappingSize_ = st.st_size;
+    if (mappingSize_ < sizeof(BinaryCaseHeader)) {
+        close(fd);
+        throw std::runtime_error(format_error() + ": " + path);
+    }
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping_ == MAP_FAILED) {
+        throw std::runtime_error("Cannot map binary case: " + path);
+    }
+    string error = load(static_cast<const char*>(mapping_), mappingSize_);
+    if (!error.empty()) {
+        munmap(mapping_, mappingSize_);
+        mapping_ = MAP_FAILED;
+        throw std::runtime_error(error + ": " + path);
+    }
+}
+
+BinaryCase::BinaryCase(const void* data, size_t size) : mapping_(MAP_FAILED), mappingSize_(0) {
+    HIKER_STATS_TIMER(StatPhase::Parse);
+    if (size < sizeof(BinaryCaseHeader) ||
+        reinterpret_cast<uintptr_t>(data) % alignof(BinaryCaseHeader) != 0) {
+        throw std::runtime_error(format_error());
+    }
+    string error = load(static_cast<const char*>(data), size);
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+string BinaryCase::load(const char* data, size_t size) {
+    header_ = reinterpret_cast<const BinaryCaseHeader*>(data);
+    // Counts are checked one by one so that the sizes cannot overflow.
+    uint64_t limit = size / sizeof(double);
+    size_t hikerCount = header_->origHikerCount + header_->additionalHikerCount;
+    bool valid = header_->magic == kMagic && header_->version == kVersion &&
+        header_->additionalHikerCount < limit && hikerCount < limit &&
+        header_->bridgeCount < limit && header_->nameCount < limit &&
+        header_->nameBytes <= size;
+    size_t offset = sizeof(BinaryCaseHeader);
+    if (valid) {
+        speeds_ = reinterpret_cast<const double*>(data + offset);
+        offset += hikerCount * sizeof(double);
+        perFeetTimes_ = reinterpret_cast<const double*>(data + offset);
+        offset += hikerCount * sizeof(double);
+        bridges_ = reinterpret_cast<const BinaryBridge*>(data + offset);
+        offset += header_->bridgeCount * sizeof(BinaryBridge);
+        nameIds_ = reinterpret_cast<const uint32_t*>(data + offset);
+        offset += hikerCount * sizeof(uint32_t);
+        nameOffsets_ = reinterpret_cast<const uint32_t*>(data + offset);
+        offset += (header_->nameCount + 1) * sizeof(uint32_t);
+        names_ = data + offset;
+        offset += header_->nameBytes;
+        valid = offset == size;
+    }
+    for (size_t i = 0; valid && i < header_->bridgeCount; ++i) {
+        valid = bridges_[i].newHikerBegin <= bridges_[i].newHikerEnd &&
+            bridges_[i].newHikerEnd <= header_->additionalHikerCount;
+    }
+    for (size_t i = 0; valid && i < header_->nameCount; ++i) {
+        valid = nameOffsets_[i] <= nameOffsets_[i + 1] &&
+            nameOffsets_[i + 1] <= header_->nameBytes;
+    }
+    if (!valid) {
+        return format_error();
+    }
+    // The values the text parsers would have rejected, and what the engines
+    // take for granted: sorted original hikers and 1 / speed per feet times.
+    for (size_t i = 0; i < hikerCount; ++i) {
+        if (!(speeds_[i] > 0) || !std::isfinite(speeds_[i])) {
+            return "Speed should > 0";
+        }
+        if (perFeetTimes_[i] != 1 / speeds_[i]) {
+            return "Per feet time should be 1 / speed";
+        }
+    }
+    for (size_t i = 1; i < header_->origHikerCount; ++i) {
+        if (speeds_[i - 1] < speeds_[i]) {
+            return "Original hikers should be sorted by speed";
+        }
+    }
+    for (size_t i = 0; i < header_->bridgeCount; ++i) {
+        if (!(bridges_[i].length > 0) || !std::isfinite(bridges_[i].length)) {
+            return "Bridge's length should > 0";
+        }
+    }
+    return string();
+}
+
+BinaryCase::~BinaryCase() {
+    if (mapping_ != MAP_FAILED) {
+        munmap(mapping_, mappingSize_);
+    }
+}
+
+HikerSpan BinaryCase::getOriginalHikers() const {
+    return HikerSpan{speeds_, perFeetTimes_, nameIds_, header_->origHikerCount};
+}
+
+HikerSpan BinaryCase::getAdditionalHikers(size_t begin, size_t end) const {
+    size_t offset = header_->origHikerCount + begin;
+    return HikerSpan{speeds_ + offset, perFeetTimes_ + offset, nameIds_ + offset, end - begin};
+}
+
+std::string_view BinaryCase::getName(uint32_t nameId) const {
+    // Name ids are checked here rather than all at load time.
+    if (nameId >= header_->nameCount) {
+        return std::string_view();
+    }
+    return std::string_view(names_ + nameOffsets_[nameId],
+        nameOffsets_[nameId + 1] - nameOffsets_[nameId]);
+}
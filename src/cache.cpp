@@ -0,0 +1,167 @@
+#include "cache.h"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "persistent_cache.h"
+
+
+namespace {
+
+uint64_t mix64(uint64_t value)
+{
+    // splitmix64 finalizer.
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+size_t floor_power_of_two(size_t value)
+{
+    size_t power = 1;
+    while (power * 2 <= value) {
+        power *= 2;
+    }
+    return power;
+}
+
+} // namespace
+
+const uint64_t GroupFingerprint::kOrigSeed;
+const uint64_t GroupFingerprint::kAdditionalSeed;
+const size_t Cache::kDefaultMemoryLimit;
+const size_t Cache::kWays;
+
+uint64_t GroupFingerprint::hashSpeed(double speed, uint64_t seed) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &speed, sizeof(bits));
+    return mix64(bits ^ seed);
+}
+
+Cache::Cache(size_t memoryLimit, size_t shardCount)
+    : persistentCache_(nullptr), hits_(0), persistentHits_(0), misses_(0), insertions_(0), evictions_(0) {
+    shardCount_ = floor_power_of_two(shardCount > 0 ? shardCount : 1);
+    slotsPerShard_ = floor_power_of_two(memoryLimit / sizeof(Slot) / shardCount_);
+    if (slotsPerShard_ < kWays) {
+        slotsPerShard_ = kWays;
+    }
+    tableBytes_ = shardCount_ * slotsPerShard_ * sizeof(Slot);
+    void* table = mmap(nullptr, tableBytes_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (table == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    table_ = static_cast<Slot*>(table);
+    shards_.reset(new Shard[shardCount_]);
+    for (size_t i = 0; i < shardCount_; ++i) {
+        shards_[i].slots = table_ + i * slotsPerShard_;
+        shards_[i].clockHand = 0;
+    }
+}
+
+Cache::~Cache() {
+    munmap(table_, tableBytes_);
+}
+
+Cache::Shard& Cache::getShard(const GroupKey& key, size_t& home) {
+    uint64_t hash = mix64(key.origHash ^ mix64(key.additionalHash));
+    home = static_cast<size_t>(hash >> 32) & (slotsPerShard_ - 1);
+    return shards_[hash & (shardCount_ - 1)];
+}
+
+double Cache::getTime(const GroupKey& key) {
+    size_t home = 0;
+    Shard& shard = getShard(key, home);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (size_t i = 0; i < kWays; ++i) {
+        Slot& slot = shard.slots[(home + i) & (slotsPerShard_ - 1)];
+        if (slot.used && slot.key == key) {
+            slot.referenced = true;
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return slot.perFeetTime;
+        }
+    }
+    if (persistentCache_) {
+        double perFeetTime = persistentCache_->getTime(key);
+        if (perFeetTime > 0) {
+            insert(shard, home, key, perFeetTime);
+            persistentHits_.fetch_add(1, std::memory_order_relaxed);
+            return perFeetTime;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return -1.0;
+}
+
+void Cache::setTime(const GroupKey& key, double perFeetTime) {
+    size_t home = 0;
+    Shard& shard = getShard(key, home);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insert(shard, home, key, perFeetTime);
+    }
+    if (persistentCache_) {
+        persistentCache_->setTime(key, perFeetTime);
+    }
+}
+
+// The shard must be locked.
+void Cache::insert(Shard& shard, size_t home, const GroupKey& key, double perFeetTime) {
+    Slot* free = nullptr;
+    for (size_t i = 0; i < kWays; ++i) {
+        Slot& slot = shard.slots[(home + i) & (slotsPerShard_ - 1)];
+        if (slot.used && slot.key == key) {
+            slot.perFeetTime = perFeetTime;
+            return;
+        }
+        if (!slot.used && !free) {
+            free = &slot;
+        }
+    }
+    if (!free) {
+        // CLOCK over the slots of this key: clear the referenced bits until
+        // a slot that was not hit lately comes up.
+        for (size_t i = 0; ; ++i) {
+            Slot& slot = shard.slots[(home + (shard.clockHand + i) % kWays) & (slotsPerShard_ - 1)];
+            if (!slot.referenced) {
+                free = &slot;
+                shard.clockHand = (shard.clockHand + i + 1) % kWays;
+                break;
+            }
+            slot.referenced = false;
+        }
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    *free = Slot{key, perFeetTime, true, false};
+    insertions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Cache::reset() {
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        // Give whole pages back, they read as zero (empty) again; a shard
+        // smaller than a page shares it with others and is cleared instead.
+        Slot* slots = shards_[i].slots;
+        size_t bytes = slotsPerShard_ * sizeof(Slot);
+        if (bytes % pageSize != 0 || madvise(slots, bytes, MADV_DONTNEED) != 0) {
+            memset(static_cast<void*>(slots), 0, bytes);
+        }
+        shards_[i].clockHand = 0;
+    }
+}
+
+CacheStats Cache::getStats() const {
+    return CacheStats{hits_.load(std::memory_order_relaxed),
+        persistentHits_.load(std::memory_order_relaxed),
+        misses_.load(std::memory_order_relaxed),
+        insertions_.load(std::memory_order_relaxed),
+        evictions_.load(std::memory_order_relaxed)};
+}
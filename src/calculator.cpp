@@ -3,13 +3,25 @@
 #include <cassert>
 #include <cmath>
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 #include <iterator>
+#include <utility>
 #include <iostream>
 #include <sstream>
 
+#include "binary_case.h"
 #include "cache.h"
+#include "crossing_plan.h"
+#include "dp_engine.h"
+#include "plan_writer.h"
+#include "hiker_group.h"
+#include "hiker_profile.h"
+#include "simd_kernels.h"
+#include "small_group.h"
+#include "stats.h"
+#include "thread_pool.h"
 
 
 using std::string;
@@ -22,54 +34,167 @@ double CrossingTimeCalculator::calcCrossingTime(const vector<Bridge>& bridges,
     if (origHikerCount == 0) {
         return -1.0;
     }
+    // Verbose prints the plan in one write after all bridges are done.
+    CrossingPlan verbosePlan;
+    CrossingPlan* plan = plan_;
+    if (verbose && !plan) {
+        plan = &verbosePlan;
+    }
+    if (plan) {
+        plan->clear();
+    }
+    double totalTime = 0.0;
+    Engine engine = engine_;
+    if (engine == Engine::Auto) {
+        size_t additionalHikerCount = bridges.empty() ? 0 :
+            bridges.back().getAdditionalHikerCount();
+        engine = chooseEngine(origHikerCount + additionalHikerCount, bridges.size());
+    }
+    if (!plan && engine != Engine::Greedy) {
+        // Only the speed columns are read, names are not interned.
+        HikerColumns& origColumns = workspace_.origHikers;
+        origColumns.clear();
+        origColumns.reserve(origHikerCount);
+        for (auto& hiker : origHikers) {
+            origColumns.addHiker(hiker.getSpeed(), hiker.getPerFeetTime(),
+                static_cast<uint32_t>(origColumns.size()));
+        }
+        BridgeSource getBridge = [&bridges](size_t bridge, HikerSpan& newHikers) {
+            newHikers = bridges[bridge].getNewHikers();
+            return bridges[bridge].getLength();
+        };
+        if (engine == Engine::Profile) {
+            totalTime = calcCrossingTimeProfile(origColumns.getSpan(), bridges.size(), getBridge);
+        }
+        else if (engine == Engine::DP) {
+            totalTime = calcCrossingTimeDP(origColumns.getSpan(), bridges.size(), getBridge);
+        }
+        else if (runsInParallel(engine, bridges.size())) {
+            totalTime = calcCrossingTimeParallel(origColumns.getSpan(), bridges.size(),
+                getBridge);
+        }
+        else {
+            totalTime = calcCrossingTimeIncremental(origColumns.getSpan(), bridges.size(),
+                getBridge);
+        }
+    }
+    else {
+        totalTime = calcCrossingTimeGreedy(bridges, origHikers, plan);
+    }
+    if (verbose) {
+        string report;
+        PlanWriter(PlanFormat::Text).write(*plan, origHikers, bridges, report);
+        std::cout.write(report.data(), report.size());
+    }
+    return totalTime;
+}
+
+CrossingTimeCalculator::Engine CrossingTimeCalculator::chooseEngine(size_t hikerCount,
+    size_t bridgeCount) {
+    // Measured on the bench cases, the faster engine switches within a
+    // factor of two of this line.
+    double greedyBridges = kGreedyBridgesPerLevel * std::log2(std::max<size_t>(hikerCount, 2));
+    return bridgeCount <= greedyBridges ? Engine::Greedy : Engine::Incremental;
+}
+
+void CrossingTimeCalculator::PlanRecorder::beginBridge(double length, size_t hikerCount) {
+    plan->beginBridge(length, hikerCount);
+}
+
+void CrossingTimeCalculator::PlanRecorder::setCacheHit() {
+    plan->setCacheHit();
+}
+
+void CrossingTimeCalculator::PlanRecorder::addStep(uint32_t first, uint32_t second,
+    uint32_t returner) {
+    plan->addStep(first, second, returner);
+}
 
+double CrossingTimeCalculator::calcCrossingTimeGreedy(const vector<Bridge>& bridges,
+    const vector<Hiker>& origHikers, CrossingPlan* plan) {
+    if (plan) {
+        PlanRecorder recorder{plan};
+        return calcCrossingTimeGreedyWith(bridges, origHikers, recorder);
+    }
+    NoPlan noPlan;
+    return calcCrossingTimeGreedyWith(bridges, origHikers, noPlan);
+}
+
+template <typename Output>
+double CrossingTimeCalculator::calcCrossingTimeGreedyWith(const vector<Bridge>& bridges,
+    const vector<Hiker>& origHikers, Output& output) {
+    size_t origHikerCount = origHikers.size();
+    HikerColumns& origColumns = workspace_.origHikers;
+    HikerColumns& additionalColumns = workspace_.additionalHikers;
+    if constexpr (!Output::kRecords) {
+        origColumns.clear();
+        origColumns.reserve(origHikerCount);
+        for (auto& hiker : origHikers) {
+            origColumns.addHiker(hiker.getSpeed(), hiker.getPerFeetTime(), 0);
+        }
+    }
+    GroupFingerprint fingerprint;
+    for (auto& hiker : origHikers) {
+        fingerprint.addOriginalHiker(hiker.getSpeed());
+    }
     double totalTime = 0.0;
     for (auto& bridge : bridges) {
-        if (verbose) {
-            std::cout << "Bridge (" << bridge.getLength() << ")" << std::endl;
-        }
+        HIKER_STATS_BRIDGE(&bridge - bridges.data());
         size_t hikerCount = origHikerCount + bridge.getAdditionalHikerCount();
+        HIKER_STATS_ADD(StatCounter::Bridges, 1);
+        HIKER_STATS_ADD(StatCounter::HikersProcessed, hikerCount);
+        output.beginBridge(bridge.getLength(), hikerCount);
+        auto newHikers = bridge.getNewHikers();
+        for (size_t i = 0; i < newHikers.size; ++i) {
+            fingerprint.addAdditionalHiker(newHikers.speeds[i]);
+        }
         double perFeetTime = 0.0;
         if (timeCache_) {
-            perFeetTime = timeCache_->getTime(hikerCount);
+            perFeetTime = timeCache_->getTime(fingerprint.getKey());
         }
         // Got cached time.
         if (perFeetTime > 0) {
             totalTime += perFeetTime * bridge.getLength();
-            if (verbose) {
-                std::cout << "Hit cache for hiker count " << hikerCount <<
-                    " at bridge with length " << bridge.getLength() << std::endl;
-            }
+            output.setCacheHit();
             continue;
         }
-        perFeetTime = calcPerFeetTime(origHikers, bridge.getAdditionalHikers(), verbose);
+        if constexpr (Output::kRecords) {
+            perFeetTime = calcPerFeetTimeWith(origHikers, bridge.getAdditionalHikers(), output);
+        }
+        else {
+            // No plan, run on the columns.
+            additionalColumns.clear();
+            if (bridge.getHikerPool()) {
+                bridge.getHikerPool()->getSortedHikers(bridge.getAdditionalHikerCount(),
+                    additionalColumns);
+            }
+            perFeetTime = calcPerFeetTime(origColumns.getSpan(), additionalColumns.getSpan());
+        }
         totalTime += perFeetTime * bridge.getLength();
         if (timeCache_) {
-            timeCache_->setTime(hikerCount, perFeetTime);
+            timeCache_->setTime(fingerprint.getKey(), perFeetTime);
         }
     }
     return totalTime;
 }
 
+template <typename Output>
 double CrossingTimeCalculator::calcPerFeetTimeHikerHelpsHikers(const Hiker& hikerLead,
-    const vector<Hiker>& hikers,
-    int startIndex, int targetIndex, bool targetIndexShouldReturn, bool verbose) {
+    const vector<Hiker>& hikers, uint32_t firstId,
+    int startIndex, int targetIndex, bool targetIndexShouldReturn, Output& output) {
     assert(targetIndex >= 0 && startIndex >= targetIndex);
     int returnCount = (startIndex+1-targetIndex) - (targetIndexShouldReturn?0:1);
-    const string& hikerLeadName = hikerLead.getName();
     double hikerLeadPerFeetTime = hikerLead.getPerFeetTime();
     // The returning time.
     double perFeetTime = hikerLeadPerFeetTime * returnCount;
     while (startIndex >= targetIndex) {
+        uint32_t id = firstId + startIndex;
         auto& hiker = hikers[startIndex--];
         // Each crossing time.
         perFeetTime += fmax(hikerLeadPerFeetTime, hiker.getPerFeetTime());
-        if (verbose) {
-            std::cout << hikerLeadName << "," << hiker.getName() << " cross";
-            if (startIndex >= targetIndex || targetIndexShouldReturn) {
-                std::cout << ", " << hikerLeadName << " returns";
-            }
-            std::cout << std::endl;
+        if constexpr (Output::kRecords) {
+            bool returns = startIndex >= targetIndex || targetIndexShouldReturn;
+            output.addStep(0, id, returns ? 0 : PlanStep::kNone);
         }
     }
     return perFeetTime;
@@ -81,10 +206,10 @@ double CrossingTimeCalculator::calcThresholdSpeed(double fastest, double second)
 
 size_t CrossingTimeCalculator::countSpeedSlowerThan(const vector<Hiker>& hikers,
     double thresholdSpeed) {
-    // TODO: Can use binary search since hikers are sorted by speed.
-    auto it = std::find_if(hikers.begin(), hikers.end(),
+    // Hikers are sorted by speed, the slower ones are at the end.
+    auto it = std::partition_point(hikers.begin(), hikers.end(),
         [thresholdSpeed](const Hiker& hiker) {
-            return hiker.getSpeed() < thresholdSpeed;
+            return hiker.getSpeed() >= thresholdSpeed;
     });
     return std::distance(it, hikers.end());
 }
@@ -113,21 +238,31 @@ const Hiker& CrossingTimeCalculator::removeSlowestHiker(const vector<Hiker>& hik
 }
 
 double CrossingTimeCalculator::calcPerFeetTime(const vector<Hiker>& hikers,
-    const vector<Hiker>& additionalHikers, bool verbose) {
+    const vector<Hiker>& additionalHikers, CrossingPlan* plan) {
+    if (plan) {
+        PlanRecorder recorder{plan};
+        return calcPerFeetTimeWith(hikers, additionalHikers, recorder);
+    }
+    NoPlan noPlan;
+    return calcPerFeetTimeWith(hikers, additionalHikers, noPlan);
+}
+
+template <typename Output>
+double CrossingTimeCalculator::calcPerFeetTimeWith(const vector<Hiker>& hikers,
+    const vector<Hiker>& additionalHikers, Output& output) {
     assert(hikers.size() >= 1);
     const Hiker& hikerLead = hikers[0];
-    const string& hikerLeadName = hikerLead.getName();
+    // Roster ids: original hikers first, then additional hikers.
+    uint32_t additionalFirstId = static_cast<uint32_t>(hikers.size());
     if (hikers.size() == 1) {
         // We assume additional hikers cannot bring back the torch, so the
         // original hiker has to help the additional ones cross the bridge
         // one by one.
         if (!additionalHikers.empty()) {
             return calcPerFeetTimeHikerHelpsHikers(hikerLead, additionalHikers,
-                additionalHikers.size()-1, 0, false, verbose);
-        }
-        if (verbose) {
-            std::cout << hikerLeadName << " crosses" << std::endl;
+                additionalFirstId, additionalHikers.size()-1, 0, false, output);
         }
+        output.addStep(0, PlanStep::kNone, PlanStep::kNone);
         return hikerLead.getPerFeetTime();
     }
 
@@ -136,6 +271,7 @@ double CrossingTimeCalculator::calcPerFeetTime(const vector<Hiker>& hikers,
     size_t slowerCount = countSpeedSlowerThan(hikers, thresholdSpeed);
     size_t additionalSlowerCount = countSpeedSlowerThan(additionalHikers, thresholdSpeed);
     size_t slowestPairCount = (slowerCount+additionalSlowerCount) >> 1;
+    HIKER_STATS_ADD(StatCounter::SlowPairs, slowestPairCount);
     int index = static_cast<int>(hikers.size() - 1);
     int additionalIndex = -1;
     if (!additionalHikers.empty()) {
@@ -148,40 +284,470 @@ double CrossingTimeCalculator::calcPerFeetTime(const vector<Hiker>& hikers,
         double timeFSCrossFReturnSReturn = hikerLead.getPerFeetTime()
             + hikers[1].getPerFeetTime()*2;
         perFeetTime += timeFSCrossFReturnSReturn * slowestPairCount;
-        const string& secondName = hikers[1].getName();
         for (size_t i = 0; i < slowestPairCount; ++i) {
             // Fastest and second cross, fastest returns,
             // Two slowest cross, second returns.
-            Hiker slowest = removeSlowestHiker(hikers, additionalHikers,
-                index, additionalIndex);
-            Hiker slowestBut1 = removeSlowestHiker(hikers, additionalHikers,
+            int lastIndex = index;
+            const Hiker& slowest = removeSlowestHiker(hikers, additionalHikers,
                 index, additionalIndex);
+            uint32_t slowestId = (index != lastIndex) ? index + 1
+                : additionalFirstId + additionalIndex + 1;
+            lastIndex = index;
+            removeSlowestHiker(hikers, additionalHikers, index, additionalIndex);
+            uint32_t slowestBut1Id = (index != lastIndex) ? index + 1
+                : additionalFirstId + additionalIndex + 1;
             perFeetTime += slowest.getPerFeetTime();
-            if (verbose) {
-                std::cout << hikerLeadName << "," << secondName << " cross, ";
-                std::cout << hikerLeadName << " returns" << std::endl;
-                std::cout << slowest.getName() << "," << slowestBut1.getName() << " cross, ";
-                std::cout << secondName << " returns" << std::endl;
-            }
+            output.addStep(0, 1, 0);
+            output.addStep(slowestId, slowestBut1Id, 1);
         }
     }
     // If there are any remaining additional hikers, help them cross the
     // bridge one by one is the fastest way.
     if (additionalIndex >= 0) {
         perFeetTime += calcPerFeetTimeHikerHelpsHikers(hikerLead, additionalHikers,
-            additionalIndex, 0, true, verbose);
+            additionalFirstId, additionalIndex, 0, true, output);
     }
     // For the remaining hikers (if any) except the fastest and the second,
     // help them cross the bridge one by one.
     if (index > 1) {
         perFeetTime += calcPerFeetTimeHikerHelpsHikers(hikerLead, hikers,
-            index, 2, true, verbose);
+            0, index, 2, true, output);
     }
     // For the fastest and the second, cross together, no return.
     perFeetTime += hikers[1].getPerFeetTime();
-    if (verbose) {
-        std::cout << hikerLeadName << "," << hikers[1].getName()
-            << " cross" << std::endl;
+    output.addStep(0, 1, PlanStep::kNone);
+    return perFeetTime;
+}
+
+template <typename Output>
+double CrossingTimeCalculator::calcPerFeetTimeHikerHelpsHikers(double leadPerFeetTime,
+    const HikerSpan& hikers, uint32_t firstId,
+    int startIndex, int targetIndex, bool targetIndexShouldReturn, Output& output) {
+    assert(targetIndex >= 0 && startIndex >= targetIndex);
+    int returnCount = (startIndex+1-targetIndex) - (targetIndexShouldReturn?0:1);
+    // The returning time.
+    double perFeetTime = leadPerFeetTime * returnCount;
+    const double* perFeetTimes = hikers.perFeetTimes;
+    if constexpr (!Output::kRecords) {
+        // Each crossing time, vectorized.
+        return perFeetTime + sum_max_per_feet_time(perFeetTimes + targetIndex,
+            startIndex + 1 - targetIndex, leadPerFeetTime);
+    }
+    else {
+        while (startIndex >= targetIndex) {
+            int row = startIndex--;
+            // Each crossing time.
+            perFeetTime += fmax(leadPerFeetTime, perFeetTimes[row]);
+            bool returns = startIndex >= targetIndex || targetIndexShouldReturn;
+            output.addStep(0, firstId + row, returns ? 0 : PlanStep::kNone);
+        }
+        return perFeetTime;
+    }
+}
+
+size_t CrossingTimeCalculator::countSpeedSlowerThan(const HikerSpan& hikers,
+    double thresholdSpeed) {
+    // A branch free count is faster than binary search on small groups.
+    if (hikers.size <= 32) {
+        return count_speed_slower_than(hikers.speeds, hikers.size, thresholdSpeed);
+    }
+    const double* end = hikers.speeds + hikers.size;
+    auto it = std::partition_point(hikers.speeds, end, [thresholdSpeed](double speed) {
+        return speed >= thresholdSpeed;
+    });
+    return end - it;
+}
+
+uint32_t CrossingTimeCalculator::removeSlowestHiker(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers,
+    int& index, int& additionalIndex, double& perFeetTime) {
+    if (index >= 0 && (additionalIndex < 0 ||
+        hikers.speeds[index] < additionalHikers.speeds[additionalIndex])) {
+        perFeetTime = hikers.perFeetTimes[index];
+        return index--;
     }
+    perFeetTime = additionalHikers.perFeetTimes[additionalIndex];
+    return static_cast<uint32_t>(hikers.size) + additionalIndex--;
+}
+
+double CrossingTimeCalculator::calcPerFeetTime(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers, CrossingPlan* plan) {
+    if (plan) {
+        PlanRecorder recorder{plan};
+        return calcPerFeetTimeWith(hikers, additionalHikers, recorder);
+    }
+    // Most groups are small, run the unrolled kernel of their size.
+    if (is_small_group(hikers.size, additionalHikers.size)) {
+        return calc_small_group_per_feet_time(hikers, additionalHikers);
+    }
+    NoPlan noPlan;
+    return calcPerFeetTimeWith(hikers, additionalHikers, noPlan);
+}
+
+double CrossingTimeCalculator::calcPerFeetTimeGeneral(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers) {
+    NoPlan noPlan;
+    return calcPerFeetTimeWith(hikers, additionalHikers, noPlan);
+}
+
+template <typename Output>
+double CrossingTimeCalculator::calcPerFeetTimeWith(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers, Output& output) {
+    assert(hikers.size >= 1);
+    double leadPerFeetTime = hikers.perFeetTimes[0];
+    uint32_t additionalFirstId = static_cast<uint32_t>(hikers.size);
+    if (hikers.size == 1) {
+        // Additional hikers cannot bring back the torch.
+        if (additionalHikers.size > 0) {
+            return calcPerFeetTimeHikerHelpsHikers(leadPerFeetTime, additionalHikers,
+                additionalFirstId, additionalHikers.size-1, 0, false, output);
+        }
+        output.addStep(0, PlanStep::kNone, PlanStep::kNone);
+        return leadPerFeetTime;
+    }
+
+    double perFeetTime = 0.0;
+    double secondPerFeetTime = hikers.perFeetTimes[1];
+    double thresholdSpeed = calcThresholdSpeed(hikers.speeds[0], hikers.speeds[1]);
+    size_t slowestPairCount = (countSpeedSlowerThan(hikers, thresholdSpeed) +
+        countSpeedSlowerThan(additionalHikers, thresholdSpeed)) >> 1;
+    HIKER_STATS_ADD(StatCounter::SlowPairs, slowestPairCount);
+    int index = static_cast<int>(hikers.size - 1);
+    int additionalIndex = static_cast<int>(additionalHikers.size) - 1;
+    if (slowestPairCount > 0) {
+        perFeetTime += (leadPerFeetTime + secondPerFeetTime*2) * slowestPairCount;
+        for (size_t i = 0; i < slowestPairCount; ++i) {
+            double slowestPerFeetTime = 0.0;
+            double slowestBut1PerFeetTime = 0.0;
+            uint32_t slowestId = removeSlowestHiker(hikers, additionalHikers,
+                index, additionalIndex, slowestPerFeetTime);
+            uint32_t slowestBut1Id = removeSlowestHiker(hikers, additionalHikers,
+                index, additionalIndex, slowestBut1PerFeetTime);
+            perFeetTime += slowestPerFeetTime;
+            output.addStep(0, 1, 0);
+            output.addStep(slowestId, slowestBut1Id, 1);
+        }
+    }
+    if (additionalIndex >= 0) {
+        perFeetTime += calcPerFeetTimeHikerHelpsHikers(leadPerFeetTime, additionalHikers,
+            additionalFirstId, additionalIndex, 0, true, output);
+    }
+    if (index > 1) {
+        perFeetTime += calcPerFeetTimeHikerHelpsHikers(leadPerFeetTime, hikers,
+            0, index, 2, true, output);
+    }
+    perFeetTime += secondPerFeetTime;
+    output.addStep(0, 1, PlanStep::kNone);
     return perFeetTime;
 }
+
+template <typename Calc>
+double CrossingTimeCalculator::calcCachedPerFeetTime(const GroupKey& key, Calc calc) {
+    if (!timeCache_) {
+        return calc();
+    }
+    double perFeetTime = timeCache_->getTime(key);
+    if (perFeetTime <= 0) {
+        perFeetTime = calc();
+        timeCache_->setTime(key, perFeetTime);
+    }
+    return perFeetTime;
+}
+
+// The group only grows from one bridge to the next, so instead of running
+// the greedy plan over all hikers again, add the new hikers to the group and
+// evaluate the plan from the group's sums. If no one joins, the previous per
+// feet time is reused. While the group is small, its additional hikers are
+// kept sorted in columns and the unrolled kernel of its size runs instead;
+// the tree is only built once the group outgrows the kernels.
+double CrossingTimeCalculator::calcCrossingTimeIncremental(const HikerSpan& origHikers,
+    size_t bridgeCount, const BridgeSource& getBridge) {
+    HikerGroup& group = workspace_.group;
+    group.clear();
+    HikerColumns& smallAdditionalHikers = workspace_.additionalHikers;
+    smallAdditionalHikers.clear();
+    bool small = true;
+    auto useTreeIfLarge = [&]() {
+        small = is_small_group(origHikers.size, smallAdditionalHikers.size());
+        if (!small) {
+            for (size_t i = 0; i < origHikers.size; ++i) {
+                group.addOriginalHiker(origHikers.speeds[i]);
+            }
+            for (size_t i = 0; i < smallAdditionalHikers.size(); ++i) {
+                group.addAdditionalHiker(smallAdditionalHikers.speeds[i]);
+            }
+        }
+    };
+    auto calc = [&]() {
+        return small ? calc_small_group_per_feet_time(origHikers,
+            smallAdditionalHikers.getSpan()) : group.calcPerFeetTime();
+    };
+    GroupFingerprint fingerprint;
+    for (size_t i = 0; i < origHikers.size; ++i) {
+        fingerprint.addOriginalHiker(origHikers.speeds[i]);
+    }
+    useTreeIfLarge();
+    double perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(), calc);
+    double totalTime = 0.0;
+    HikerSpan newHikers;
+    for (size_t bridge = 0; bridge < bridgeCount; ++bridge) {
+        HIKER_STATS_BRIDGE(bridge);
+        double length = getBridge(bridge, newHikers);
+        if (newHikers.size > 0) {
+            for (size_t i = 0; i < newHikers.size; ++i) {
+                fingerprint.addAdditionalHiker(newHikers.speeds[i]);
+                if (small) {
+                    smallAdditionalHikers.addHiker(newHikers.speeds[i],
+                        newHikers.perFeetTimes[i], 0);
+                }
+                else {
+                    group.addAdditionalHiker(newHikers.speeds[i]);
+                }
+            }
+            if (small) {
+                smallAdditionalHikers.sortBySpeed(workspace_.sortBuffers, workspace_.scratch);
+                useTreeIfLarge();
+            }
+            perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(), calc);
+        }
+        HIKER_STATS_ADD(StatCounter::Bridges, 1);
+        HIKER_STATS_ADD(StatCounter::HikersProcessed,
+            small ? origHikers.size + smallAdditionalHikers.size() : group.getHikerCount());
+        totalTime += perFeetTime * length;
+    }
+    return totalTime;
+}
+
+// Same walk as the incremental engine, on prefix sums instead of a tree.
+double CrossingTimeCalculator::calcCrossingTimeProfile(const HikerSpan& origHikers,
+    size_t bridgeCount, const BridgeSource& getBridge) {
+    GroupFingerprint fingerprint;
+    for (size_t i = 0; i < origHikers.size; ++i) {
+        fingerprint.addOriginalHiker(origHikers.speeds[i]);
+    }
+    HikerProfile& profile = workspace_.profile;
+    profile.build(origHikers, HikerSpan{nullptr, nullptr, nullptr, 0});
+    double perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(),
+        [&profile]() { return profile.calcPerFeetTime(); });
+    HikerColumns& newHikers = workspace_.newHikers;
+    HikerSpan newHikerSpan;
+    double totalTime = 0.0;
+    for (size_t bridge = 0; bridge < bridgeCount; ++bridge) {
+        HIKER_STATS_BRIDGE(bridge);
+        double length = getBridge(bridge, newHikerSpan);
+        if (newHikerSpan.size > 0) {
+            // Only the new hikers need sorting before they are merged in.
+            newHikers.clear();
+            for (size_t i = 0; i < newHikerSpan.size; ++i) {
+                newHikers.addHiker(newHikerSpan.speeds[i], newHikerSpan.perFeetTimes[i],
+                    newHikerSpan.nameIds[i]);
+                fingerprint.addAdditionalHiker(newHikerSpan.speeds[i]);
+            }
+            newHikers.sortBySpeed(workspace_.sortBuffers, workspace_.scratch);
+            profile.addHikers(newHikers.getSpan());
+            perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(),
+                [&profile]() { return profile.calcPerFeetTime(); });
+        }
+        HIKER_STATS_ADD(StatCounter::Bridges, 1);
+        HIKER_STATS_ADD(StatCounter::HikersProcessed, profile.getHikerCount());
+        totalTime += perFeetTime * length;
+    }
+    return totalTime;
+}
+
+namespace {
+
+const uint64_t kDPKeySalt = 0x5bd1e9955bd1e995ull;
+
+// The dp engine finds a lower time than the greedy plan for some groups, so
+// its results are cached under keys of their own.
+GroupKey dp_key(const GroupKey& key) {
+    return GroupKey{key.origHash ^ kDPKeySalt, key.additionalHash};
+}
+
+} // namespace
+
+// Same walk as the profile engine, with the dynamic program on the merged
+// columns.
+double CrossingTimeCalculator::calcCrossingTimeDP(const HikerSpan& origHikers,
+    size_t bridgeCount, const BridgeSource& getBridge) {
+    GroupFingerprint fingerprint;
+    for (size_t i = 0; i < origHikers.size; ++i) {
+        fingerprint.addOriginalHiker(origHikers.speeds[i]);
+    }
+    HikerColumns& additionalHikers = workspace_.additionalHikers;
+    HikerColumns& newHikers = workspace_.newHikers;
+    HikerColumns& merged = workspace_.scratch;
+    additionalHikers.clear();
+    double perFeetTime = calcCachedPerFeetTime(dp_key(fingerprint.getKey()), [&]() {
+        return calc_dp_per_feet_time(origHikers, additionalHikers.getSpan());
+    });
+    HikerSpan newHikerSpan;
+    double totalTime = 0.0;
+    for (size_t bridge = 0; bridge < bridgeCount; ++bridge) {
+        HIKER_STATS_BRIDGE(bridge);
+        double length = getBridge(bridge, newHikerSpan);
+        if (newHikerSpan.size > 0) {
+            newHikers.clear();
+            for (size_t i = 0; i < newHikerSpan.size; ++i) {
+                newHikers.addHiker(newHikerSpan.speeds[i], newHikerSpan.perFeetTimes[i],
+                    newHikerSpan.nameIds[i]);
+                fingerprint.addAdditionalHiker(newHikerSpan.speeds[i]);
+            }
+            // The merged columns are free until the merge.
+            newHikers.sortBySpeed(workspace_.sortBuffers, merged);
+            // Merge, the hikers met first go first among equal speeds.
+            merged.clear();
+            merged.reserve(additionalHikers.size() + newHikers.size());
+            size_t index = 0;
+            size_t newIndex = 0;
+            while (index < additionalHikers.size() || newIndex < newHikers.size()) {
+                if (newIndex == newHikers.size() || (index < additionalHikers.size() &&
+                    additionalHikers.speeds[index] >= newHikers.speeds[newIndex])) {
+                    merged.addHiker(additionalHikers.speeds[index],
+                        additionalHikers.perFeetTimes[index], additionalHikers.nameIds[index]);
+                    ++index;
+                }
+                else {
+                    merged.addHiker(newHikers.speeds[newIndex],
+                        newHikers.perFeetTimes[newIndex], newHikers.nameIds[newIndex]);
+                    ++newIndex;
+                }
+            }
+            std::swap(additionalHikers, merged);
+            perFeetTime = calcCachedPerFeetTime(dp_key(fingerprint.getKey()), [&]() {
+                return calc_dp_per_feet_time(origHikers, additionalHikers.getSpan());
+            });
+        }
+        HIKER_STATS_ADD(StatCounter::Bridges, 1);
+        HIKER_STATS_ADD(StatCounter::HikersProcessed, origHikers.size + additionalHikers.size());
+        totalTime += perFeetTime * length;
+    }
+    return totalTime;
+}
+
+namespace {
+
+// Sum in a fixed tree order, so that the rounding does not depend on which
+// thread finished first.
+double pairwise_sum(const double* values, size_t count) {
+    if (count == 0) {
+        return 0.0;
+    }
+    if (count == 1) {
+        return values[0];
+    }
+    size_t half = count / 2;
+    return pairwise_sum(values, half) + pairwise_sum(values + half, count - half);
+}
+
+// Merge the sorted (descending) runs [begin, end) into `merged`.
+void merge_runs(const vector<vector<double>>& runs, size_t begin, size_t end,
+    vector<double>& merged) {
+    if (end - begin == 1) {
+        merged = runs[begin];
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    vector<double> left;
+    vector<double> right;
+    merge_runs(runs, begin, middle, left);
+    merge_runs(runs, middle, end, right);
+    merged.resize(left.size() + right.size());
+    std::merge(left.begin(), left.end(), right.begin(), right.end(), merged.begin(),
+        std::greater<double>());
+}
+
+} // namespace
+
+bool CrossingTimeCalculator::runsInParallel(Engine engine, size_t bridgeCount) const {
+    return threadPool_ && engine == Engine::Incremental &&
+        bridgeCount >= kMinParallelChunkBridges * 2;
+}
+
+// The group at a bridge is the original hikers plus the new hikers of every
+// bridge up to it, so each chunk of bridges only needs the hikers met before
+// it. First each chunk sorts and hashes its own new hikers; then each chunk
+// merges the runs before it (its prefix), builds its starting group in one
+// pass and walks its bridges like the incremental engine.
+double CrossingTimeCalculator::calcCrossingTimeParallel(const HikerSpan& origHikers,
+    size_t bridgeCount, const BridgeSource& getBridge) {
+    size_t chunkCount = std::min(kMaxParallelChunks, bridgeCount / kMinParallelChunkBridges);
+    size_t chunkSize = (bridgeCount + chunkCount - 1) / chunkCount;
+    // Run 0 is the original hikers, run c + 1 the new hikers of chunk c.
+    vector<vector<double>> runs(chunkCount + 1);
+    vector<GroupFingerprint> fingerprints(chunkCount + 1);
+    runs[0].assign(origHikers.speeds, origHikers.speeds + origHikers.size);
+    for (size_t i = 0; i < origHikers.size; ++i) {
+        fingerprints[0].addOriginalHiker(origHikers.speeds[i]);
+    }
+    threadPool_->parallelFor(chunkCount, [&](size_t chunk, size_t) {
+        vector<double>& speeds = runs[chunk + 1];
+        HikerSpan newHikers;
+        size_t end = std::min(bridgeCount, (chunk + 1) * chunkSize);
+        for (size_t bridge = chunk * chunkSize; bridge < end; ++bridge) {
+            getBridge(bridge, newHikers);
+            for (size_t i = 0; i < newHikers.size; ++i) {
+                speeds.push_back(newHikers.speeds[i]);
+                fingerprints[chunk + 1].addAdditionalHiker(newHikers.speeds[i]);
+            }
+        }
+        std::sort(speeds.begin(), speeds.end(), std::greater<double>());
+    });
+
+    vector<double> chunkTimes(chunkCount);
+    threadPool_->parallelFor(chunkCount, [&](size_t chunk, size_t) {
+        vector<double> speeds;
+        merge_runs(runs, 0, chunk + 1, speeds);
+        HikerGroup group;
+        group.build(origHikers.speeds, origHikers.size, speeds.data(), speeds.size());
+        GroupFingerprint fingerprint;
+        for (size_t run = 0; run <= chunk; ++run) {
+            fingerprint.addGroup(fingerprints[run]);
+        }
+        double perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(),
+            [&group]() { return group.calcPerFeetTime(); });
+        double chunkTime = 0.0;
+        HikerSpan newHikers;
+        size_t end = std::min(bridgeCount, (chunk + 1) * chunkSize);
+        for (size_t bridge = chunk * chunkSize; bridge < end; ++bridge) {
+            HIKER_STATS_BRIDGE(bridge);
+            double length = getBridge(bridge, newHikers);
+            if (newHikers.size > 0) {
+                for (size_t i = 0; i < newHikers.size; ++i) {
+                    group.addAdditionalHiker(newHikers.speeds[i]);
+                    fingerprint.addAdditionalHiker(newHikers.speeds[i]);
+                }
+                perFeetTime = calcCachedPerFeetTime(fingerprint.getKey(),
+                    [&group]() { return group.calcPerFeetTime(); });
+            }
+            HIKER_STATS_ADD(StatCounter::Bridges, 1);
+            HIKER_STATS_ADD(StatCounter::HikersProcessed, group.getHikerCount());
+            chunkTime += perFeetTime * length;
+        }
+        chunkTimes[chunk] = chunkTime;
+    });
+    return pairwise_sum(chunkTimes.data(), chunkCount);
+}
+
+double CrossingTimeCalculator::calcCrossingTime(const BinaryCase& binaryCase) {
+    HikerSpan origHikers = binaryCase.getOriginalHikers();
+    if (origHikers.size == 0) {
+        return -1.0;
+    }
+    BridgeSource getBridge = [&binaryCase](size_t bridge, HikerSpan& newHikers) {
+        newHikers = binaryCase.getNewHikers(bridge);
+        return binaryCase.getBridge(bridge).length;
+    };
+    if (engine_ == Engine::Profile) {
+        return calcCrossingTimeProfile(origHikers, binaryCase.getBridgeCount(), getBridge);
+    }
+    if (engine_ == Engine::DP) {
+        return calcCrossingTimeDP(origHikers, binaryCase.getBridgeCount(), getBridge);
+    }
+    Engine engine = engine_ == Engine::Auto ? Engine::Incremental : engine_;
+    if (runsInParallel(engine, binaryCase.getBridgeCount())) {
+        return calcCrossingTimeParallel(origHikers, binaryCase.getBridgeCount(), getBridge);
+    }
+    return calcCrossingTimeIncremental(origHikers, binaryCase.getBridgeCount(), getBridge);
+}
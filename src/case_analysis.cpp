@@ -0,0 +1,188 @@
+#include "case_analysis.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "hiker_group.h"
+
+
+using std::string;
+using std::vector;
+
+namespace {
+
+size_t first_bridge(size_t arrival)
+{
+    return arrival == CaseAnalysis::kOriginal ? 0 : arrival;
+}
+
+} // namespace
+
+CaseAnalysis::CaseAnalysis(const vector<Bridge>& bridges, const vector<Hiker>& origHikers)
+    : lengthSums_(1, 0.0), timeSums_(1, 0.0), totalTime_(-1.0) {
+    HikerGroup group;
+    for (auto& hiker : origHikers) {
+        hikers_.push_back(HikerInfo{hiker.getName(), hiker.getSpeed(), kOriginal});
+        group.addOriginalHiker(hiker.getSpeed());
+    }
+    double perFeetTime = 0.0;
+    for (size_t bridge = 0; bridge < bridges.size(); ++bridge) {
+        HikerSpan newHikers = bridges[bridge].getNewHikers();
+        if (bridge == 0 || newHikers.size > 0) {
+            segments_.push_back(Segment{bridge, bridge, {}});
+            for (size_t i = 0; i < newHikers.size; ++i) {
+                const NameTable& names = bridges[bridge].getHikerPool()->getTable().getNames();
+                segments_.back().arrivals.push_back(static_cast<uint32_t>(hikers_.size()));
+                hikers_.push_back(HikerInfo{string(names.getName(newHikers.nameIds[i])),
+                    newHikers.speeds[i], bridge});
+                group.addAdditionalHiker(newHikers.speeds[i]);
+            }
+            perFeetTime = group.calcPerFeetTime();
+        }
+        segments_.back().end = bridge + 1;
+        double length = bridges[bridge].getLength();
+        lengthSums_.push_back(lengthSums_.back() + length);
+        timeSums_.push_back(timeSums_.back() + perFeetTime * length);
+    }
+    if (!origHikers.empty()) {
+        totalTime_ = timeSums_.back();
+    }
+}
+
+size_t CaseAnalysis::findHiker(std::string_view name) const {
+    for (size_t hiker = 0; hiker < hikers_.size(); ++hiker) {
+        if (hikers_[hiker].name == name) {
+            return hiker;
+        }
+    }
+    return hikers_.size();
+}
+
+CaseAnalysis::Query CaseAnalysis::makeQuery(const CaseChange& change) const {
+    bool hasHiker = change.kind != CaseChange::Kind::AddHiker;
+    bool hasSpeed = change.kind == CaseChange::Kind::AddHiker ||
+        change.kind == CaseChange::Kind::ChangeSpeed;
+    bool hasBridge = change.kind == CaseChange::Kind::AddHiker ||
+        change.kind == CaseChange::Kind::MoveArrival;
+    if (hasHiker && change.hiker >= hikers_.size()) {
+        throw std::invalid_argument("No hiker " + std::to_string(change.hiker));
+    }
+    if (hasSpeed && !(change.speed > 0)) {
+        throw std::invalid_argument("Speed should > 0");
+    }
+    if (hasBridge && change.bridge != kOriginal && change.bridge >= getBridgeCount()) {
+        throw std::invalid_argument("No bridge " + std::to_string(change.bridge));
+    }
+    Query query;
+    query.deltaCount = 0;
+    if (hasHiker) {
+        // The hiker as in the case leaves; for a speed change or a move, the
+        // changed hiker joins again.
+        const HikerInfo& hiker = hikers_[change.hiker];
+        query.deltas[query.deltaCount++] = Delta{first_bridge(hiker.arrival), hiker.speed,
+            hiker.arrival == kOriginal, false};
+        if (change.kind == CaseChange::Kind::ChangeSpeed) {
+            query.deltas[query.deltaCount++] = Delta{first_bridge(hiker.arrival), change.speed,
+                hiker.arrival == kOriginal, true};
+        }
+        else if (change.kind == CaseChange::Kind::MoveArrival) {
+            query.deltas[query.deltaCount++] = Delta{first_bridge(change.bridge), hiker.speed,
+                change.bridge == kOriginal, true};
+        }
+    }
+    else {
+        query.deltas[query.deltaCount++] = Delta{first_bridge(change.bridge), change.speed,
+            change.bridge == kOriginal, true};
+    }
+    query.begin = query.deltas[0].begin;
+    if (query.deltaCount == 2) {
+        query.begin = std::min(query.begin, query.deltas[1].begin);
+    }
+    return query;
+}
+
+namespace {
+
+void apply_delta(HikerGroup& group, double speed, bool original, bool add)
+{
+    if (add) {
+        if (original) {
+            group.addOriginalHiker(speed);
+        }
+        else {
+            group.addAdditionalHiker(speed);
+        }
+    }
+    else if (original) {
+        group.removeOriginalHiker(speed);
+    }
+    else {
+        group.removeAdditionalHiker(speed);
+    }
+}
+
+} // namespace
+
+vector<double> CaseAnalysis::evaluate(const vector<CaseChange>& changes) const {
+    vector<Query> queries;
+    queries.reserve(changes.size());
+    for (auto& change : changes) {
+        queries.push_back(makeQuery(change));
+    }
+    // Bridges before a query's first delta keep the case's time.
+    vector<double> totals(queries.size());
+    vector<bool> feasible(queries.size(), true);
+    for (size_t q = 0; q < queries.size(); ++q) {
+        totals[q] = timeSums_[queries[q].begin];
+    }
+
+    HikerGroup group;
+    for (auto& hiker : hikers_) {
+        if (hiker.arrival == kOriginal) {
+            group.addOriginalHiker(hiker.speed);
+        }
+    }
+    for (auto& segment : segments_) {
+        for (auto hiker : segment.arrivals) {
+            group.addAdditionalHiker(hikers_[hiker].speed);
+        }
+        for (size_t q = 0; q < queries.size(); ++q) {
+            const Query& query = queries[q];
+            // Split the segment where a delta starts applying.
+            size_t from = std::max(segment.begin, query.begin);
+            while (feasible[q] && from < segment.end) {
+                size_t to = segment.end;
+                for (size_t d = 0; d < query.deltaCount; ++d) {
+                    if (query.deltas[d].begin > from) {
+                        to = std::min(to, query.deltas[d].begin);
+                    }
+                }
+                for (size_t d = 0; d < query.deltaCount; ++d) {
+                    const Delta& delta = query.deltas[d];
+                    if (delta.begin <= from) {
+                        apply_delta(group, delta.speed, delta.original, delta.add);
+                    }
+                }
+                double perFeetTime = group.calcPerFeetTime();
+                for (size_t d = query.deltaCount; d-- > 0;) {
+                    const Delta& delta = query.deltas[d];
+                    if (delta.begin <= from) {
+                        apply_delta(group, delta.speed, delta.original, !delta.add);
+                    }
+                }
+                if (perFeetTime < 0) {
+                    feasible[q] = false;
+                    break;
+                }
+                totals[q] += perFeetTime * (lengthSums_[to] - lengthSums_[from]);
+                from = to;
+            }
+        }
+    }
+    for (size_t q = 0; q < queries.size(); ++q) {
+        if (!feasible[q]) {
+            totals[q] = -1.0;
+        }
+    }
+    return totals;
+}
@@ -0,0 +1,473 @@
+#include "case_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "binary_case.h"
+#include "calculator.h"
+#include "fast_case_parser.h"
+
+
+using std::string;
+using std::vector;
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+const uint32_t kStatusOk = 0;
+const uint32_t kStatusError = 1;
+
+// How long stop() waits for clients to read their last responses.
+const auto kStopWriteTimeout = std::chrono::seconds(1);
+
+bool read_full(int fd, void* data, size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t count = recv(fd, bytes, size, 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool write_full(int fd, const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        // No SIGPIPE if the peer is gone, just a failed write.
+        ssize_t count = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+sockaddr_un socket_address(const string& socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+}
+
+string frame(uint32_t status, const void* payload, size_t size)
+{
+    uint32_t header[2] = {static_cast<uint32_t>(size), status};
+    string response(reinterpret_cast<const char*>(header), sizeof(header));
+    response.append(static_cast<const char*>(payload), size);
+    return response;
+}
+
+// Nearest rank; `values` is reordered.
+double percentile(vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    auto nth = values.begin() + static_cast<size_t>(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+} // namespace
+
+// Shared by its reader, its writer and its requests; the fd is closed with
+// the last of them.
+struct CaseServer::Connection {
+    explicit Connection(int fd)
+        : fd(fd), backlog(0), backlogBytes(0), readerDone(false), stopping(false) {}
+    ~Connection() { close(fd); }
+
+    int fd;
+    std::mutex mutex;
+    std::condition_variable changed;
+    // Responses in request order, waiting for the writer.
+    std::deque<string> responses;
+    // Requests read but whose responses are not written yet, and the bytes
+    // they take: the request until it is solved, then the response.
+    size_t backlog;
+    size_t backlogBytes;
+    bool readerDone;
+    bool stopping;
+};
+
+struct CaseServer::Request {
+    std::shared_ptr<Connection> connection;
+    uint32_t format;
+    size_t size;
+    vector<uint64_t> data; // 8-byte aligned, as a binary case needs.
+    Clock::time_point received;
+    string response;
+};
+
+CaseServer::CaseServer(const string& socketPath, size_t threadCount, Cache* cache)
+    : socketPath_(socketPath), cache_(cache), pool_(threadCount), listenFd_(-1),
+      readerCount_(0), writerCount_(0), stopping_(false), batchCount_(0) {
+    sockaddr_un address = socket_address(socketPath);
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        throw std::runtime_error(string("Cannot create socket: ") + strerror(errno));
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd_, SOMAXCONN) != 0) {
+        string error = strerror(errno);
+        close(listenFd_);
+        throw std::runtime_error("Cannot listen at " + socketPath + " (" + error + ")");
+    }
+    batchThread_ = std::thread(&CaseServer::batchLoop, this);
+    acceptThread_ = std::thread(&CaseServer::acceptLoop, this);
+}
+
+CaseServer::~CaseServer() {
+    stop();
+}
+
+void CaseServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        // Wakes the readers up; the fds are closed with their connections.
+        for (auto& threads : connections_) {
+            Connection* connection = threads.connection;
+            if (!connection) {
+                continue;
+            }
+            shutdown(connection->fd, SHUT_RD);
+            std::lock_guard<std::mutex> connectionLock(connection->mutex);
+            connection->stopping = true;
+            connection->changed.notify_all();
+        }
+    }
+    // The accept thread may wait for a connection to end.
+    threadsDone_.notify_all();
+    shutdown(listenFd_, SHUT_RDWR);
+    acceptThread_.join();
+    close(listenFd_);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        threadsDone_.wait(lock, [this] { return readerCount_ == 0; });
+    }
+    queueReady_.notify_all();
+    batchThread_.join();
+    {
+        // Writers blocked on a client that does not read are cut off.
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!threadsDone_.wait_for(lock, kStopWriteTimeout,
+                [this] { return writerCount_ == 0; })) {
+            for (auto& threads : connections_) {
+                if (threads.connection) {
+                    shutdown(threads.connection->fd, SHUT_RDWR);
+                }
+            }
+            threadsDone_.wait(lock, [this] { return writerCount_ == 0; });
+        }
+    }
+    for (auto& threads : connections_) {
+        threads.reader.join();
+        threads.writer.join();
+    }
+    connections_.clear();
+    unlink(socketPath_.c_str());
+}
+
+void CaseServer::acceptLoop() {
+    while (true) {
+        std::list<ConnectionThreads> finished;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            threadsDone_.wait(lock, [this] {
+                return writerCount_ < kMaxCaseConnections || stopping_;
+            });
+            if (stopping_) {
+                return;
+            }
+            for (auto it = connections_.begin(); it != connections_.end();) {
+                auto next = std::next(it);
+                if (!it->connection) {
+                    finished.splice(finished.end(), connections_, it);
+                }
+                it = next;
+            }
+        }
+        for (auto& threads : finished) {
+            threads.reader.join();
+            threads.writer.join();
+        }
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || fd < 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+        auto connection = std::make_shared<Connection>(fd);
+        connections_.emplace_back();
+        ConnectionThreads& threads = connections_.back();
+        threads.connection = connection.get();
+        ++readerCount_;
+        ++writerCount_;
+        threads.reader = std::thread(&CaseServer::readLoop, this, connection);
+        threads.writer = std::thread(&CaseServer::writeLoop, this, connection, &threads);
+    }
+}
+
+void CaseServer::readLoop(std::shared_ptr<Connection> connection) {
+    while (true) {
+        {
+            // A client that does not read its responses is not read either.
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&connection] {
+                return connection->backlog < kMaxCaseBacklog || connection->stopping;
+            });
+        }
+        uint32_t header[2];
+        if (!read_full(connection->fd, header, sizeof(header))) {
+            break;
+        }
+        std::unique_ptr<Request> request(new Request);
+        request->connection = connection;
+        request->format = header[1];
+        request->size = header[0];
+        bool tooLarge = request->size > kMaxCaseRequestBytes;
+        {
+            // Nor are more bytes read than kMaxCaseBacklogBytes allows.
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            size_t size = tooLarge ? 0 : request->size;
+            connection->changed.wait(lock, [&connection, size] {
+                return connection->backlogBytes + size <= kMaxCaseBacklogBytes ||
+                    connection->backlogBytes == 0 || connection->stopping;
+            });
+            ++connection->backlog;
+            connection->backlogBytes += size;
+        }
+        if (tooLarge) {
+            const char message[] = "Case too large";
+            request->response = frame(kStatusError, message, sizeof(message) - 1);
+        }
+        else {
+            request->data.resize((request->size + 7) / 8);
+            if (!read_full(connection->fd, request->data.data(), request->size)) {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                --connection->backlog;
+                connection->backlogBytes -= request->size;
+                break;
+            }
+        }
+        request->received = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(request));
+        }
+        queueReady_.notify_one();
+        if (tooLarge) {
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->readerDone = true;
+        connection->changed.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    --readerCount_;
+    threadsDone_.notify_all();
+}
+
+void CaseServer::writeLoop(std::shared_ptr<Connection> connection,
+    ConnectionThreads* threads) {
+    bool connected = true;
+    while (true) {
+        string response;
+        {
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&connection] {
+                return !connection->responses.empty() ||
+                    (connection->readerDone && connection->backlog == 0);
+            });
+            if (connection->responses.empty()) {
+                break;
+            }
+            response = std::move(connection->responses.front());
+            connection->responses.pop_front();
+        }
+        // Once the client is gone the responses are only dropped.
+        connected = connected && write_full(connection->fd, response.data(), response.size());
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        --connection->backlog;
+        connection->backlogBytes -= response.size();
+        connection->changed.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads->connection = nullptr;
+    --writerCount_;
+    threadsDone_.notify_all();
+}
+
+void CaseServer::batchLoop() {
+    vector<CrossingTimeCalculator> calcs(pool_.getThreadCount(),
+        CrossingTimeCalculator(cache_));
+    vector<std::unique_ptr<Request>> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueReady_.wait(lock, [this] {
+                return !queue_.empty() || (stopping_ && readerCount_ == 0);
+            });
+            if (queue_.empty()) {
+                return;
+            }
+            size_t count = std::min(queue_.size(), kMaxCaseBatch);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        pool_.parallelFor(batch.size(), [&](size_t index, size_t worker) {
+            solve(*batch[index], calcs[worker]);
+        });
+        // Counted before the responses go out, so that a client that got its
+        // response finds it in the stats.
+        Clock::time_point sent = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            for (auto& request : batch) {
+                latencies_.push_back(std::chrono::duration<double, std::micro>(
+                    sent - request->received).count());
+            }
+            ++batchCount_;
+        }
+        // In queue order, so each connection gets its answers in order.
+        for (auto& request : batch) {
+            Connection& connection = *request->connection;
+            std::lock_guard<std::mutex> lock(connection.mutex);
+            if (request->size <= kMaxCaseRequestBytes) {
+                connection.backlogBytes -= request->size;
+            }
+            connection.backlogBytes += request->response.size();
+            connection.responses.push_back(std::move(request->response));
+            connection.changed.notify_all();
+        }
+        // The requests' bytes are no longer counted, so they are freed.
+        batch.clear();
+    }
+}
+
+void CaseServer::solve(Request& request, CrossingTimeCalculator& calc) {
+    if (!request.response.empty()) {
+        return;
+    }
+    string error;
+    double totalTime = 0.0;
+    try {
+        if (request.format == static_cast<uint32_t>(CaseFormat::String)) {
+            std::string_view strCase(reinterpret_cast<const char*>(request.data.data()),
+                request.size);
+            vector<Hiker> origHikers;
+            vector<Bridge> bridges;
+            CaseParseError parseError;
+            if (FastCaseParser().parse(strCase, origHikers, bridges, parseError)) {
+                totalTime = calc.calcCrossingTime(bridges, origHikers, false);
+            }
+            else {
+                error = "Parse case error at " + std::to_string(parseError.position) + ": " +
+                    parseError.message;
+            }
+        }
+        else if (request.format == static_cast<uint32_t>(CaseFormat::Binary)) {
+            totalTime = calc.calcCrossingTime(BinaryCase(request.data.data(), request.size));
+        }
+        else {
+            error = "Unknown case format " + std::to_string(request.format);
+        }
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    request.response = error.empty() ?
+        frame(kStatusOk, &totalTime, sizeof(totalTime)) :
+        frame(kStatusError, error.data(), error.size());
+}
+
+LatencyStats CaseServer::takeLatencyStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    LatencyStats stats{latencies_.size(), batchCount_, 0.0, 0.0};
+    stats.p50Micros = percentile(latencies_, 0.5);
+    stats.p99Micros = percentile(latencies_, 0.99);
+    latencies_.clear();
+    batchCount_ = 0;
+    return stats;
+}
+
+CaseClient::CaseClient(const string& socketPath) {
+    sockaddr_un address = socket_address(socketPath);
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        string error = strerror(errno);
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        throw std::runtime_error("Cannot connect to " + socketPath + " (" + error + ")");
+    }
+}
+
+CaseClient::~CaseClient() {
+    close(fd_);
+}
+
+double CaseClient::solve(CaseFormat format, std::string_view data) {
+    uint32_t header[2] = {static_cast<uint32_t>(data.size()), static_cast<uint32_t>(format)};
+    if (!write_full(fd_, header, sizeof(header)) || !write_full(fd_, data.data(), data.size()) ||
+        !read_full(fd_, header, sizeof(header))) {
+        throw std::runtime_error("Connection to the case server lost");
+    }
+    string payload(header[0], '\0');
+    if (!read_full(fd_, &payload[0], payload.size())) {
+        throw std::runtime_error("Connection to the case server lost");
+    }
+    if (header[1] != kStatusOk) {
+        throw std::invalid_argument(payload);
+    }
+    double totalTime = 0.0;
+    if (payload.size() != sizeof(totalTime)) {
+        throw std::runtime_error("Bad response from the case server");
+    }
+    memcpy(&totalTime, payload.data(), sizeof(totalTime));
+    return totalTime;
+}
@@ -0,0 +1,80 @@
+#include "crossing_session.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "stats.h"
+
+
+void CrossingSession::addHiker(std::string_view name, double speed) {
+    if (!(speed > 0)) {
+        throw std::invalid_argument("Speed should > 0");
+    }
+    bool original = bridgeCount_ == 0;
+    if (original) {
+        group_.addOriginalHiker(speed);
+        fingerprint_.addOriginalHiker(speed);
+    }
+    else {
+        group_.addAdditionalHiker(speed);
+        fingerprint_.addAdditionalHiker(speed);
+    }
+    members_[std::string(name)].push_back(Member{speed, original});
+    groupChanged_ = true;
+}
+
+bool CrossingSession::removeHiker(std::string_view name) {
+    auto it = members_.find(std::string(name));
+    if (it == members_.end()) {
+        return false;
+    }
+    Member member = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty()) {
+        members_.erase(it);
+    }
+    if (member.original) {
+        group_.removeOriginalHiker(member.speed);
+        fingerprint_.removeOriginalHiker(member.speed);
+    }
+    else {
+        group_.removeAdditionalHiker(member.speed);
+        fingerprint_.removeAdditionalHiker(member.speed);
+    }
+    groupChanged_ = true;
+    return true;
+}
+
+double CrossingSession::addBridge(double length) {
+    HIKER_STATS_BRIDGE(bridgeCount_);
+    if (!(length > 0)) {
+        throw std::invalid_argument("Bridge's length should > 0");
+    }
+    if (group_.getOriginalHikerCount() == 0) {
+        throw std::invalid_argument("Case format error: No original hiker");
+    }
+    if (groupChanged_) {
+        updatePerFeetTime();
+    }
+    HIKER_STATS_ADD(StatCounter::Bridges, 1);
+    HIKER_STATS_ADD(StatCounter::HikersProcessed, group_.getHikerCount());
+    double time = perFeetTime_ * length;
+    totalTime_ += time;
+    ++bridgeCount_;
+    return time;
+}
+
+void CrossingSession::reset() {
+    group_.clear();
+    fingerprint_ = GroupFingerprint();
+    members_.clear();
+    perFeetTime_ = 0.0;
+    groupChanged_ = true;
+    totalTime_ = 0.0;
+    bridgeCount_ = 0;
+}
+
+void CrossingSession::updatePerFeetTime() {
+    groupChanged_ = false;
+    perFeetTime_ = group_.calcPerFeetTime(cache_, fingerprint_.getKey());
+}
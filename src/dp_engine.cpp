@@ -0,0 +1,55 @@
+#include "dp_engine.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+double calc_dp_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    assert(hikers.size >= 1);
+    double leadPerFeetTime = hikers.perFeetTimes[0];
+    if (hikers.size == 1) {
+        // No one else can bring the torch back: A takes each additional
+        // hiker across and returns, except after the last one.
+        if (additionalHikers.size == 0) {
+            return leadPerFeetTime;
+        }
+        double perFeetTime = leadPerFeetTime * (additionalHikers.size - 1);
+        for (size_t i = 0; i < additionalHikers.size; ++i) {
+            perFeetTime += std::fmax(leadPerFeetTime, additionalHikers.perFeetTimes[i]);
+        }
+        return perFeetTime;
+    }
+    double secondPerFeetTime = hikers.perFeetTimes[1];
+    double pairTrips = leadPerFeetTime + secondPerFeetTime * 2;
+    // dp[i - 2], dp[i - 1] and the per feet time of the (i - 1)th slowest.
+    double beforeLast = 0.0;
+    double last = 0.0;
+    double lastPerFeetTime = 0.0;
+    bool hasLast = false;
+    // The others from the slowest: original hikers after B merged with the
+    // additional hikers.
+    size_t index = hikers.size;
+    size_t additionalIndex = additionalHikers.size;
+    while (index > 2 || additionalIndex > 0) {
+        double perFeetTime;
+        if (additionalIndex == 0 || (index > 2 &&
+            hikers.speeds[index - 1] < additionalHikers.speeds[additionalIndex - 1])) {
+            perFeetTime = hikers.perFeetTimes[--index];
+        }
+        else {
+            perFeetTime = additionalHikers.perFeetTimes[--additionalIndex];
+        }
+        double best = last + std::fmax(leadPerFeetTime, perFeetTime) + leadPerFeetTime;
+        if (hasLast) {
+            // This one crosses with the slower one before, who sets the pace.
+            best = std::min(best, beforeLast + pairTrips + lastPerFeetTime);
+        }
+        beforeLast = last;
+        last = best;
+        lastPerFeetTime = perFeetTime;
+        hasLast = true;
+    }
+    return last + secondPerFeetTime;
+}
@@ -0,0 +1,116 @@
+#include "fast_case_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "hiker_pool.h"
+#include "utils.h"
+#include "stats.h"
+
+
+using std::string_view;
+using std::vector;
+
+bool FastCaseParser::parse(string_view strCase,
+    vector<Hiker>& origHikers, vector<Bridge>& bridges, CaseParseError& error) {
+    HIKER_STATS_TIMER(StatPhase::Parse);
+    input_ = strCase;
+    pos_ = 0;
+    error_ = &error;
+    // Size the outputs from the separators, so that they grow once: commas
+    // separate hikers, semicolons start bridges.
+    size_t origEnd = std::min(strCase.find(';'), strCase.size());
+    size_t origCommas = std::count(strCase.begin(), strCase.begin() + origEnd, ',');
+    origHikers.reserve(origHikers.size() + origCommas + 1);
+    string_view name;
+    double speed = 0.0;
+    // Original hikers: name1 speed1, ..., name-n speed-n
+    while (true) {
+        if (!parseHiker(name, speed)) {
+            return false;
+        }
+        origHikers.emplace_back(std::string(name), speed);
+        if (pos_ == input_.size() || input_[pos_] != ',') {
+            break;
+        }
+        ++pos_;
+    }
+    if (pos_ == input_.size()) {
+        return fail(pos_, "No bridge");
+    }
+    if (input_[pos_] != ';') {
+        return fail(pos_, "Expected ',' or ';' after a hiker");
+    }
+    sort_hikers(origHikers);
+    // All bridges share the pool of additional hikers.
+    auto additionalHikers = std::make_shared<HikerPool>();
+    additionalHikers->reserve(std::count(strCase.begin() + pos_, strCase.end(), ','));
+    bridges.reserve(bridges.size() + std::count(strCase.begin() + pos_, strCase.end(), ';'));
+    while (pos_ < input_.size()) {
+        ++pos_; // ';'
+        // Bridge: length, additionalHiker1 speed1, ..., additionalHiker-n speed-n
+        size_t lengthPosition = pos_;
+        double length = 0.0;
+        if (!parseNumber(length)) {
+            return false;
+        }
+        if (length <= 0) {
+            return fail(lengthPosition, "Bridge's length should > 0");
+        }
+        size_t size = additionalHikers->size();
+        while (pos_ < input_.size() && input_[pos_] == ',') {
+            ++pos_;
+            if (!parseHiker(name, speed)) {
+                return false;
+            }
+            additionalHikers->addHiker(name, speed);
+        }
+        if (pos_ < input_.size() && input_[pos_] != ';') {
+            return fail(pos_, "Expected ',' or ';' after a bridge item");
+        }
+        bridges.emplace_back(Bridge(length, additionalHikers, size, additionalHikers->size()));
+    }
+    additionalHikers->sortBySpeed();
+    return true;
+}
+
+// Hiker: name speed
+bool FastCaseParser::parseHiker(string_view& name, double& speed) {
+    size_t begin = pos_;
+    size_t end = input_.find_first_of(" ,;", begin);
+    if (end == string_view::npos || input_[end] != ' ') {
+        return fail(end == string_view::npos ? input_.size() : end, "Hiker format error");
+    }
+    name = input_.substr(begin, end - begin);
+    pos_ = end + 1;
+    size_t speedPosition = pos_;
+    if (!parseNumber(speed)) {
+        return false;
+    }
+    if (!(speed > 0)) {
+        return fail(speedPosition, "Speed should > 0");
+    }
+    return true;
+}
+
+bool FastCaseParser::parseNumber(double& value) {
+    const char* begin = input_.data() + pos_;
+    const char* end = input_.data() + input_.size();
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc()) {
+        return fail(pos_, result.ec == std::errc::result_out_of_range ?
+            "Number out of range" : "Invalid number");
+    }
+    pos_ += result.ptr - begin;
+    return true;
+}
+
+bool FastCaseParser::fail(size_t position, const char* message) {
+    *error_ = CaseParseError{position, message};
+    return false;
+}
@@ -0,0 +1,72 @@
+#include "group_engine.h"
+
+#include <cstring>
+
+#include "calculator.h"
+#include "dp_engine.h"
+#include "hiker_group.h"
+#include "hiker_profile.h"
+#include "small_group.h"
+
+
+namespace {
+
+double dp_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    return calc_dp_per_feet_time(hikers, additionalHikers);
+}
+
+double greedy_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    return CrossingTimeCalculator(nullptr).calcPerFeetTimeGeneral(hikers, additionalHikers);
+}
+
+double small_group_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    return calc_small_group_per_feet_time(hikers, additionalHikers);
+}
+
+// Build the tree and the profile of the group each time, as the incremental
+// and profile engines would for a group whose hikers are all new.
+double tree_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    HikerGroup group;
+    for (size_t i = 0; i < hikers.size; ++i) {
+        group.addOriginalHiker(hikers.speeds[i]);
+    }
+    for (size_t i = 0; i < additionalHikers.size; ++i) {
+        group.addAdditionalHiker(additionalHikers.speeds[i]);
+    }
+    return group.calcPerFeetTime();
+}
+
+double profile_per_feet_time(const HikerSpan& hikers, const HikerSpan& additionalHikers)
+{
+    HikerProfile profile;
+    profile.build(hikers, additionalHikers);
+    return profile.calcPerFeetTime();
+}
+
+} // namespace
+
+const std::vector<GroupEngine>& get_group_engines()
+{
+    static const std::vector<GroupEngine> engines = {
+        {"greedy", &greedy_per_feet_time, nullptr, false},
+        {"small-group", &small_group_per_feet_time, &is_small_group, false},
+        {"tree", &tree_per_feet_time, nullptr, false},
+        {"profile", &profile_per_feet_time, nullptr, false},
+        {"dp", &dp_per_feet_time, nullptr, true},
+    };
+    return engines;
+}
+
+const GroupEngine* find_group_engine(const char* name)
+{
+    for (auto& engine : get_group_engines()) {
+        if (std::strcmp(engine.name, name) == 0) {
+            return &engine;
+        }
+    }
+    return nullptr;
+}
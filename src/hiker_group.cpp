@@ -0,0 +1,328 @@
+#include "hiker_group.h"
+
+#include <cassert>
+#include <vector>
+
+#include "cache.h"
+#include "hiker.h"
+#include "stats.h"
+
+
+using std::vector;
+
+namespace {
+
+const uint32_t kSeed = 2463534242u;
+
+} // namespace
+
+SpeedTree::SpeedTree() : nodes_(1, Node{0, 0, 0, 0, 0, 0, 0, 0, 0}),
+    root_(0), seed_(kSeed) {
+}
+
+void SpeedTree::insert(double speed) {
+    assert(speed > 0);
+    uint32_t left = 0;
+    uint32_t right = 0;
+    split(root_, speed, true, left, right);
+    uint32_t node = newNode(speed);
+    root_ = merge(merge(left, node), right);
+}
+
+bool SpeedTree::erase(double speed) {
+    uint32_t left = 0;
+    uint32_t middle = 0;
+    uint32_t right = 0;
+    split(root_, speed, false, left, right);
+    split(right, speed, true, middle, right);
+    bool found = middle != 0;
+    if (found) {
+        // Only one hiker with this speed leaves.
+        freeNodes_.push_back(middle);
+        middle = merge(nodes_[middle].left, nodes_[middle].right);
+    }
+    root_ = merge(merge(left, middle), right);
+    return found;
+}
+
+void SpeedTree::clear() {
+    nodes_.resize(1);
+    freeNodes_.clear();
+    root_ = 0;
+    // Same priorities as a new tree, so the same sums are added in the same
+    // order. Memory is kept for the next hikers.
+    seed_ = kSeed;
+}
+
+void SpeedTree::build(const double* speeds, size_t count) {
+    clear();
+    nodes_.reserve(count + 1);
+    root_ = buildSubtree(speeds, 0, count, 0);
+}
+
+double SpeedTree::select(size_t rank) const {
+    assert(rank < size());
+    uint32_t node = root_;
+    while (true) {
+        const Node& n = nodes_[node];
+        size_t leftCount = nodes_[n.left].count;
+        if (rank < leftCount) {
+            node = n.left;
+        }
+        else if (rank == leftCount) {
+            return n.speed;
+        }
+        else {
+            rank -= leftCount + 1;
+            node = n.right;
+        }
+    }
+}
+
+size_t SpeedTree::countSpeedSlowerThan(double speed) const {
+    size_t count = 0;
+    uint32_t node = root_;
+    while (node) {
+        const Node& n = nodes_[node];
+        if (n.speed < speed) {
+            count += nodes_[n.right].count + 1;
+            node = n.left;
+        }
+        else {
+            node = n.right;
+        }
+    }
+    return count;
+}
+
+size_t SpeedTree::countSpeedFasterThan(double speed) const {
+    size_t count = 0;
+    uint32_t node = root_;
+    while (node) {
+        const Node& n = nodes_[node];
+        if (n.speed > speed) {
+            count += nodes_[n.left].count + 1;
+            node = n.right;
+        }
+        else {
+            node = n.left;
+        }
+    }
+    return count;
+}
+
+double SpeedTree::sumPerFeetTime(size_t begin, size_t end) const {
+    return rangeSum(root_, 0, begin, end, -1);
+}
+
+double SpeedTree::sumPerFeetTime(size_t begin, size_t end, size_t parity) const {
+    return rangeSum(root_, 0, begin, end, static_cast<int>(parity & 1));
+}
+
+uint32_t SpeedTree::newNode(double speed) {
+    // xorshift32, good enough for treap priorities and reproducible.
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    double perFeetTime = 1 / speed;
+    Node node{speed, perFeetTime, perFeetTime, perFeetTime, 0, seed_, 1, 0, 0};
+    if (!freeNodes_.empty()) {
+        uint32_t index = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[index] = node;
+        return index;
+    }
+    nodes_.push_back(node);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void SpeedTree::update(uint32_t node) {
+    Node& n = nodes_[node];
+    const Node& left = nodes_[n.left];
+    const Node& right = nodes_[n.right];
+    n.count = left.count + 1 + right.count;
+    n.sum = left.sum + n.perFeetTime + right.sum;
+    if (left.count % 2 == 0) {
+        // This node is at an even position, the right subtree starts at an
+        // odd position.
+        n.evenSum = left.evenSum + n.perFeetTime + right.oddSum;
+        n.oddSum = left.oddSum + right.evenSum;
+    }
+    else {
+        n.evenSum = left.evenSum + right.evenSum;
+        n.oddSum = left.oddSum + n.perFeetTime + right.oddSum;
+    }
+}
+
+void SpeedTree::split(uint32_t node, double speed, bool equalGoesLeft,
+    uint32_t& left, uint32_t& right) {
+    if (!node) {
+        left = right = 0;
+        return;
+    }
+    Node& n = nodes_[node];
+    if (n.speed > speed || (equalGoesLeft && n.speed == speed)) {
+        split(n.right, speed, equalGoesLeft, nodes_[node].right, right);
+        left = node;
+    }
+    else {
+        split(n.left, speed, equalGoesLeft, left, nodes_[node].left);
+        right = node;
+    }
+    update(node);
+}
+
+uint32_t SpeedTree::merge(uint32_t left, uint32_t right) {
+    if (!left || !right) {
+        return left ? left : right;
+    }
+    if (nodes_[left].priority > nodes_[right].priority) {
+        uint32_t merged = merge(nodes_[left].right, right);
+        nodes_[left].right = merged;
+        update(left);
+        return left;
+    }
+    uint32_t merged = merge(left, nodes_[right].left);
+    nodes_[right].left = merged;
+    update(right);
+    return right;
+}
+
+uint32_t SpeedTree::buildSubtree(const double* speeds, size_t begin, size_t end,
+    uint32_t depth) {
+    if (begin == end) {
+        return 0;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    uint32_t node = newNode(speeds[middle]);
+    // Hikers inserted later get random priorities, so they mostly hang
+    // below the built nodes.
+    nodes_[node].priority = UINT32_MAX - depth;
+    uint32_t left = buildSubtree(speeds, begin, middle, depth + 1);
+    uint32_t right = buildSubtree(speeds, middle + 1, end, depth + 1);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+    update(node);
+    return node;
+}
+
+double SpeedTree::subtreeSum(uint32_t node, size_t offset, int parity) const {
+    const Node& n = nodes_[node];
+    if (parity < 0) {
+        return n.sum;
+    }
+    return (offset % 2 == static_cast<size_t>(parity)) ? n.evenSum : n.oddSum;
+}
+
+double SpeedTree::rangeSum(uint32_t node, size_t offset,
+    size_t begin, size_t end, int parity) const {
+    const Node& n = nodes_[node];
+    if (!node || end <= offset || begin >= offset + n.count) {
+        return 0.0;
+    }
+    if (begin <= offset && offset + n.count <= end) {
+        return subtreeSum(node, offset, parity);
+    }
+    size_t position = offset + nodes_[n.left].count;
+    double sum = rangeSum(n.left, offset, begin, end, parity);
+    if (position >= begin && position < end &&
+        (parity < 0 || position % 2 == static_cast<size_t>(parity))) {
+        sum += n.perFeetTime;
+    }
+    return sum + rangeSum(n.right, position + 1, begin, end, parity);
+}
+
+HikerGroup::HikerGroup(const vector<Hiker>& origHikers) {
+    for (auto& hiker : origHikers) {
+        addOriginalHiker(hiker.getSpeed());
+    }
+}
+
+void HikerGroup::addOriginalHiker(double speed) {
+    origHikers_.insert(speed);
+    hikers_.insert(speed);
+}
+
+void HikerGroup::addAdditionalHiker(double speed) {
+    hikers_.insert(speed);
+}
+
+bool HikerGroup::removeOriginalHiker(double speed) {
+    if (!origHikers_.erase(speed)) {
+        return false;
+    }
+    hikers_.erase(speed);
+    return true;
+}
+
+bool HikerGroup::removeAdditionalHiker(double speed) {
+    // Do not take away the speed of an original hiker.
+    size_t count = hikers_.size() - hikers_.countSpeedFasterThan(speed) -
+        hikers_.countSpeedSlowerThan(speed);
+    size_t origCount = origHikers_.size() - origHikers_.countSpeedFasterThan(speed) -
+        origHikers_.countSpeedSlowerThan(speed);
+    if (count <= origCount) {
+        return false;
+    }
+    return hikers_.erase(speed);
+}
+
+void HikerGroup::clear() {
+    hikers_.clear();
+    origHikers_.clear();
+}
+
+void HikerGroup::build(const double* origSpeeds, size_t origCount,
+    const double* speeds, size_t count) {
+    origHikers_.build(origSpeeds, origCount);
+    hikers_.build(speeds, count);
+}
+
+double HikerGroup::calcPerFeetTime(Cache* cache, const GroupKey& key) const {
+    if (cache) {
+        double perFeetTime = cache->getTime(key);
+        if (perFeetTime > 0) {
+            return perFeetTime;
+        }
+    }
+    double perFeetTime = calcPerFeetTime();
+    if (cache) {
+        cache->setTime(key, perFeetTime);
+    }
+    return perFeetTime;
+}
+
+double HikerGroup::calcPerFeetTime() const {
+    if (origHikers_.size() == 0) {
+        return -1.0;
+    }
+    double fastest = origHikers_.select(0);
+    double fastestTime = 1 / fastest;
+    size_t count = hikers_.size();
+    if (count == 1) {
+        return fastestTime;
+    }
+
+    double perFeetTime = 0.0;
+    size_t slowestPairCount = 0;
+    if (origHikers_.size() >= 2) {
+        double second = origHikers_.select(1);
+        double secondTime = 1 / second;
+        double thresholdSpeed = 1.0 / (2.0/second - 1.0/fastest);
+        slowestPairCount = hikers_.countSpeedSlowerThan(thresholdSpeed) >> 1;
+        HIKER_STATS_ADD(StatCounter::SlowPairs, slowestPairCount);
+        // Fastest and second cross, fastest returns, two slowest cross,
+        // second returns. Only the slowest of each pair counts.
+        perFeetTime += (fastestTime + secondTime*2) * slowestPairCount;
+        size_t pairBegin = count - slowestPairCount*2;
+        perFeetTime += hikers_.sumPerFeetTime(pairBegin, count, pairBegin + 1);
+    }
+    // Everyone else crosses with the fastest, who returns each time except
+    // for the last trip with the second (or with the last hiker). Hikers
+    // faster than the fastest original hiker still walk at the fastest pace.
+    size_t restCount = count - slowestPairCount*2;
+    size_t fasterCount = hikers_.countSpeedFasterThan(fastest);
+    perFeetTime += fastestTime * (static_cast<double>(restCount + fasterCount) - 3.0);
+    perFeetTime += hikers_.sumPerFeetTime(fasterCount, restCount);
+    return perFeetTime;
+}
@@ -0,0 +1,66 @@
+#include "hiker_pool.h"
+
+#include <numeric>
+#include <vector>
+
+#include "speed_sort.h"
+#include "stats.h"
+
+
+using std::vector;
+
+void HikerPool::sortBySpeed() {
+    HIKER_STATS_TIMER(StatPhase::Sort);
+    sortedIndexes_.resize(hikers_.size());
+    std::iota(sortedIndexes_.begin(), sortedIndexes_.end(), 0);
+    sort_rows_by_speed(hikers_.getColumns().speeds.data(), sortedIndexes_);
+}
+
+void HikerPool::getSortedIndexes(size_t count, vector<uint32_t>& indexes) const {
+    indexes.clear();
+    if (sortedIndexes_.size() == hikers_.size()) {
+        // Filter the sorted pool, no sorting needed.
+        indexes.reserve(count);
+        for (auto index : sortedIndexes_) {
+            if (index < count) {
+                indexes.push_back(index);
+            }
+        }
+        return;
+    }
+    indexes.resize(count);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    sort_rows_by_speed(hikers_.getColumns().speeds.data(), indexes);
+}
+
+vector<Hiker> HikerPool::getSortedHikers(size_t count) const {
+    vector<uint32_t> indexes;
+    getSortedIndexes(count, indexes);
+    vector<Hiker> hikers;
+    hikers.reserve(count);
+    for (auto index : indexes) {
+        hikers.push_back(hikers_.getHiker(index));
+    }
+    return hikers;
+}
+
+void HikerPool::getSortedHikers(size_t count, HikerColumns& sorted) const {
+    sorted.clear();
+    sorted.reserve(count);
+    if (sortedIndexes_.size() == hikers_.size()) {
+        // Filter the sorted pool straight into the columns, no index copy.
+        for (auto index : sortedIndexes_) {
+            if (index < count) {
+                sorted.addHiker(hikers_.getSpeed(index), hikers_.getPerFeetTime(index),
+                    hikers_.getNameId(index));
+            }
+        }
+        return;
+    }
+    vector<uint32_t> indexes;
+    getSortedIndexes(count, indexes);
+    for (auto index : indexes) {
+        sorted.addHiker(hikers_.getSpeed(index), hikers_.getPerFeetTime(index),
+            hikers_.getNameId(index));
+    }
+}
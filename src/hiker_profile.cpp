@@ -0,0 +1,112 @@
+#include "hiker_profile.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "stats.h"
+
+
+using std::vector;
+
+void HikerProfile::build(const HikerSpan& origHikers, const HikerSpan& additionalHikers) {
+    origHikerCount_ = origHikers.size;
+    if (origHikerCount_ >= 1) {
+        fastestSpeed_ = origHikers.speeds[0];
+        fastestPerFeetTime_ = origHikers.perFeetTimes[0];
+    }
+    if (origHikerCount_ >= 2) {
+        secondSpeed_ = origHikers.speeds[1];
+        secondPerFeetTime_ = origHikers.perFeetTimes[1];
+    }
+    speeds_.assign(origHikers.speeds, origHikers.speeds + origHikers.size);
+    perFeetTimes_.assign(origHikers.perFeetTimes, origHikers.perFeetTimes + origHikers.size);
+    updatePrefixSums(0);
+    addHikers(additionalHikers);
+}
+
+void HikerProfile::addHikers(const HikerSpan& additionalHikers) {
+    if (additionalHikers.size == 0) {
+        return;
+    }
+    // Merge from the back, in place: the hikers faster than every new one
+    // are not moved and keep their prefix sums. Among equal speeds the
+    // hikers already there go first.
+    size_t index = speeds_.size();
+    size_t additionalIndex = additionalHikers.size;
+    size_t end = index + additionalIndex;
+    speeds_.resize(end);
+    perFeetTimes_.resize(end);
+    while (additionalIndex > 0) {
+        --end;
+        if (index > 0 && speeds_[index - 1] < additionalHikers.speeds[additionalIndex - 1]) {
+            --index;
+            speeds_[end] = speeds_[index];
+            perFeetTimes_[end] = perFeetTimes_[index];
+        }
+        else {
+            --additionalIndex;
+            speeds_[end] = additionalHikers.speeds[additionalIndex];
+            perFeetTimes_[end] = additionalHikers.perFeetTimes[additionalIndex];
+        }
+    }
+    updatePrefixSums(index);
+}
+
+void HikerProfile::updatePrefixSums(size_t begin) {
+    size_t count = speeds_.size();
+    prefixSums_.resize(count + 1);
+    paritySums_[0].resize(count + 1);
+    paritySums_[1].resize(count + 1);
+    prefixSums_[0] = paritySums_[0][0] = paritySums_[1][0] = 0.0;
+    for (size_t i = begin; i < count; ++i) {
+        double perFeetTime = perFeetTimes_[i];
+        prefixSums_[i+1] = prefixSums_[i] + perFeetTime;
+        paritySums_[i%2][i+1] = paritySums_[i%2][i] + perFeetTime;
+        paritySums_[1-i%2][i+1] = paritySums_[1-i%2][i];
+    }
+}
+
+double HikerProfile::sumPerFeetTime(size_t begin, size_t end) const {
+    return prefixSums_[end] - prefixSums_[begin];
+}
+
+double HikerProfile::sumPerFeetTime(size_t begin, size_t end, size_t parity) const {
+    auto& sums = paritySums_[parity%2];
+    return sums[end] - sums[begin];
+}
+
+double HikerProfile::calcPerFeetTime() const {
+    if (origHikerCount_ == 0) {
+        return -1.0;
+    }
+    size_t count = speeds_.size();
+    if (count == 1) {
+        return fastestPerFeetTime_;
+    }
+
+    double perFeetTime = 0.0;
+    size_t slowestPairCount = 0;
+    if (origHikerCount_ >= 2) {
+        double thresholdSpeed = 1.0 / (2.0/secondSpeed_ - 1.0/fastestSpeed_);
+        size_t slowerBegin = std::partition_point(speeds_.begin(), speeds_.end(),
+            [thresholdSpeed](double speed) {
+                return speed >= thresholdSpeed;
+        }) - speeds_.begin();
+        slowestPairCount = (count - slowerBegin) >> 1;
+        HIKER_STATS_ADD(StatCounter::SlowPairs, slowestPairCount);
+        // Fastest and second cross, fastest returns, two slowest cross,
+        // second returns. Only the slowest of each pair counts.
+        perFeetTime += (fastestPerFeetTime_ + secondPerFeetTime_*2) * slowestPairCount;
+        size_t pairBegin = count - slowestPairCount*2;
+        perFeetTime += sumPerFeetTime(pairBegin, count, pairBegin + 1);
+    }
+    // Everyone else crosses with the fastest, see HikerGroup::calcPerFeetTime.
+    size_t restCount = count - slowestPairCount*2;
+    size_t fasterCount = std::partition_point(speeds_.begin(), speeds_.end(),
+        [this](double speed) {
+            return speed > fastestSpeed_;
+    }) - speeds_.begin();
+    perFeetTime += fastestPerFeetTime_ * (static_cast<double>(restCount + fasterCount) - 3.0);
+    perFeetTime += sumPerFeetTime(fasterCount, restCount);
+    return perFeetTime;
+}
@@ -0,0 +1,125 @@
+#include "hiker_table.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hiker.h"
+#include "speed_sort.h"
+
+
+using std::string;
+using std::vector;
+
+NameTable::NameTable() : arena_(new Arena()), ids_(IdMap::allocator_type(arena_.get())) {
+}
+
+NameTable::NameTable(const NameTable& other) : NameTable() {
+    *this = other;
+}
+
+NameTable& NameTable::operator=(const NameTable& other) {
+    if (this != &other) {
+        // Copy the names into our own arena, in id order.
+        NameTable copy;
+        copy.names_.reserve(other.names_.size());
+        for (auto name : other.names_) {
+            copy.intern(name);
+        }
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+// The other table is left without an arena: it can only be assigned to or
+// destroyed.
+NameTable::NameTable(NameTable&& other) noexcept : arena_(std::move(other.arena_)),
+    ids_(std::move(other.ids_)), names_(std::move(other.names_)) {
+}
+
+NameTable& NameTable::operator=(NameTable&& other) noexcept {
+    // Swapping keeps each map with the arena that holds its nodes.
+    arena_.swap(other.arena_);
+    ids_.swap(other.ids_);
+    names_.swap(other.names_);
+    return *this;
+}
+
+uint32_t NameTable::intern(std::string_view name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(arena_->copyString(name));
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+void HikerColumns::addHiker(double speed, double perFeetTime, uint32_t nameId) {
+    speeds.push_back(speed);
+    perFeetTimes.push_back(perFeetTime);
+    nameIds.push_back(nameId);
+}
+
+void HikerColumns::reserve(size_t count) {
+    speeds.reserve(count);
+    perFeetTimes.reserve(count);
+    nameIds.reserve(count);
+}
+
+void HikerColumns::clear() {
+    speeds.clear();
+    perFeetTimes.clear();
+    nameIds.clear();
+}
+
+void HikerColumns::sortBySpeed() {
+    SpeedSortBuffers buffers;
+    HikerColumns scratch;
+    sortBySpeed(buffers, scratch);
+}
+
+void HikerColumns::sortBySpeed(SpeedSortBuffers& buffers, HikerColumns& scratch) {
+    vector<uint32_t>& rows = buffers.rows;
+    rows.resize(size());
+    std::iota(rows.begin(), rows.end(), 0);
+    sort_rows_by_speed(speeds.data(), rows, buffers);
+    scratch.clear();
+    scratch.reserve(rows.size());
+    for (auto row : rows) {
+        scratch.addHiker(speeds[row], perFeetTimes[row], nameIds[row]);
+    }
+    std::swap(*this, scratch);
+}
+
+HikerSpan HikerColumns::getSpan(size_t begin, size_t end) const {
+    if (begin >= end) {
+        return HikerSpan{nullptr, nullptr, nullptr, 0};
+    }
+    return HikerSpan{speeds.data() + begin, perFeetTimes.data() + begin,
+        nameIds.data() + begin, end - begin};
+}
+
+size_t HikerTable::addHiker(std::string_view name, double speed) {
+    // Same value as Hiker::getPerFeetTime().
+    columns_.addHiker(speed, 1 / speed, names_.intern(name));
+    return columns_.size() - 1;
+}
+
+size_t HikerTable::addHiker(const Hiker& hiker) {
+    columns_.addHiker(hiker.getSpeed(), hiker.getPerFeetTime(), names_.intern(hiker.getName()));
+    return columns_.size() - 1;
+}
+
+void HikerTable::clear() {
+    columns_.clear();
+    names_ = NameTable();
+}
+
+Hiker HikerTable::getHiker(size_t row) const {
+    return Hiker(std::string(getName(row)), getSpeed(row));
+}
+
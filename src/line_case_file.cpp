@@ -0,0 +1,158 @@
+#include "line_case_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "calculator.h"
+#include "fast_case_parser.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+LineCaseFile::LineCaseFile(const string& path) : mapping_(nullptr), size_(0) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        string error = strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("Cannot open line case file: " + path + " (" + error + ")");
+    }
+    size_ = st.st_size;
+    // An empty file cannot be mapped, and has no case anyway.
+    if (size_ > 0) {
+        mapping_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            close(fd);
+            throw std::runtime_error("Cannot map line case file: " + path);
+        }
+        // Chunks are read front to back; let the kernel read ahead.
+        madvise(mapping_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+}
+
+LineCaseFile::~LineCaseFile() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, size_);
+    }
+}
+
+vector<size_t> LineCaseFile::splitChunks(size_t chunkSize) const {
+    const char* data = static_cast<const char*>(mapping_);
+    vector<size_t> offsets(1, 0);
+    size_t offset = 0;
+    while (chunkSize > 0 && size_ - offset > chunkSize) {
+        // The chunk ends after the first newline in its last byte or later.
+        size_t end = offset + chunkSize - 1;
+        end += find_byte(data + end, size_ - end, '\n') + 1;
+        if (end >= size_) {
+            break;
+        }
+        offsets.push_back(end);
+        offset = end;
+    }
+    offsets.push_back(size_);
+    return offsets;
+}
+
+namespace {
+
+// What a worker keeps from one case to the next.
+struct LineWorker {
+    explicit LineWorker(Cache* cache) : calc(cache) {}
+
+    CrossingTimeCalculator calc;
+    vector<Hiker> origHikers;
+    vector<Bridge> bridges;
+};
+
+void append_number(string& out, size_t value)
+{
+    char buffer[32];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+void solve_line(string_view line, LineWorker& worker, string& out, LineCaseSummary& summary)
+{
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (line.empty()) {
+        out += '\n';
+        return;
+    }
+    ++summary.caseCount;
+    worker.origHikers.clear();
+    worker.bridges.clear();
+    CaseParseError error;
+    if (!FastCaseParser().parse(line, worker.origHikers, worker.bridges, error)) {
+        out += "Parse case error at ";
+        append_number(out, error.position);
+        out += ": ";
+        out += error.message;
+        out += '\n';
+        ++summary.errorCount;
+        return;
+    }
+    double totalTime = worker.calc.calcCrossingTime(worker.bridges, worker.origHikers, false);
+    char buffer[32];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), totalTime).ptr);
+    out += '\n';
+}
+
+} // namespace
+
+LineCaseSummary solve_line_cases(const LineCaseFile& input, std::ostream& output,
+    ThreadPool& pool, Cache* cache) {
+    string_view data = input.getData();
+    vector<size_t> offsets = input.splitChunks();
+    size_t chunkCount = offsets.size() - 1;
+    vector<LineWorker> workers(pool.getThreadCount(), LineWorker(cache));
+    // A few chunks per worker at a time, so that uneven chunks balance out
+    // while the results of a wave are written in order.
+    size_t waveSize = pool.getThreadCount() * 4;
+    vector<string> results(std::min(waveSize, chunkCount));
+    vector<LineCaseSummary> summaries(results.size());
+    LineCaseSummary summary{0, 0};
+    for (size_t wave = 0; wave < chunkCount; wave += waveSize) {
+        size_t count = std::min(waveSize, chunkCount - wave);
+        pool.parallelFor(count, [&](size_t index, size_t worker) {
+            size_t begin = offsets[wave + index];
+            size_t end = offsets[wave + index + 1];
+            string& out = results[index];
+            out.clear();
+            summaries[index] = LineCaseSummary{0, 0};
+            while (begin < end) {
+                size_t length = find_byte(data.data() + begin, end - begin, '\n');
+                solve_line(data.substr(begin, length), workers[worker], out, summaries[index]);
+                begin += length + 1;
+            }
+        });
+        for (size_t index = 0; index < count; ++index) {
+            output.write(results[index].data(), results[index].size());
+            summary.caseCount += summaries[index].caseCount;
+            summary.errorCount += summaries[index].errorCount;
+        }
+    }
+    output.flush();
+    return summary;
+}
@@ -1,61 +1,395 @@
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <yaml-cpp/yaml.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <csignal>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "hiker.h"
 #include "bridge.h"
+#include "binary_case.h"
 #include "cache.h"
 #include "calculator.h"
-#include "yaml_parser.h"
+#include "case_analysis.h"
+#include "case_server.h"
+#include "crossing_plan.h"
+#include "crossing_session.h"
+#include "fast_case_parser.h"
+#include "line_case_file.h"
+#include "persistent_cache.h"
+#include "plan_writer.h"
+#include "stats.h"
+#include "yaml_event_parser.h"
+#include "streaming_solver.h"
 #include "string_parser.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 
 using std::string;
 using std::vector;
 
-void run_yaml_case(const string& filename, bool verbose=false)
+// With a pool, the bridges are split across its threads (see
+// CrossingTimeCalculator::setThreadPool); the plan is not recorded then.
+void run_yaml_case(const string& filename, Cache& cache, bool verbose=false,
+    PlanFormat planFormat=PlanFormat::Text, ThreadPool* pool=nullptr)
 {
     vector<Hiker> origHikers;
     vector<Bridge> bridges;
     try {
-        YAMLCaseParser parser;
-        YAML::Node config = YAML::LoadFile(filename);
-        parser.parse(config, origHikers, bridges);
+        YAMLEventCaseParser().parseFile(filename, origHikers, bridges);
     }
     catch (const std::exception& e) {
         std::cerr << "Parse case error: " << e.what() << std::endl;
         return;
     }
-    if (verbose) {
-        std::cout << "Case (accumulated additional hikers):\n"
-            << to_string_case(origHikers, bridges) << std::endl;
-    }
-    Cache cache;
     CrossingTimeCalculator calc(&cache);
-    double totalTime = calc.calcCrossingTime(bridges, origHikers, verbose);
+    calc.setThreadPool(pool);
+    double totalTime = 0.0;
+    if (verbose && planFormat != PlanFormat::Text) {
+        // Only the plan, in one write.
+        CrossingPlan plan;
+        calc.setPlan(&plan);
+        totalTime = calc.calcCrossingTime(bridges, origHikers, false);
+        string report;
+        PlanWriter(planFormat).write(plan, origHikers, bridges, report);
+        std::cout.write(report.data(), report.size());
+    }
+    else {
+        if (verbose) {
+            std::cout << "Case (accumulated additional hikers):\n"
+                << to_string_case(origHikers, bridges) << std::endl;
+        }
+        totalTime = calc.calcCrossingTime(bridges, origHikers, verbose);
+    }
     std::cout << "Total crossing time is " << totalTime << " minute(s)" << std::endl;
 }
 
-// Test code
+// Solve a binary case, see BinaryCase.
+void run_binary_case(const string& filename, Cache& cache, ThreadPool* pool=nullptr)
+{
+    double totalTime = 0.0;
+    try {
+        BinaryCase binaryCase(filename);
+        CrossingTimeCalculator calc(&cache);
+        calc.setThreadPool(pool);
+        totalTime = calc.calcCrossingTime(binaryCase);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Parse case error: " << e.what() << std::endl;
+        return;
+    }
+    std::cout << "Total crossing time is " << totalTime << " minute(s)" << std::endl;
+}
 
-double run_case(const string& strCase, bool verbose=false)
+// Convert a YAML case to the binary case format.
+int convert_case(const string& yamlFile, const string& binaryFile)
 {
     vector<Hiker> origHikers;
     vector<Bridge> bridges;
     try {
-        CaseParser parser;
-        parser.parse(strCase, origHikers, bridges);
+        YAMLEventCaseParser().parseFile(yamlFile, origHikers, bridges);
+        write_binary_case(binaryFile, origHikers, bridges);
     }
     catch (const std::exception& e) {
+        std::cerr << "Convert case error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Solve each bridge as soon as it is read and print the running total.
+// A .yaml file is read as YAML, anything else (or "-" for stdin) in the
+// string case format.
+void run_streaming_case(const string& filename, Cache& cache)
+{
+    StreamingSolver solver(&cache);
+    solver.setListener([](size_t bridge, double length, double totalTime) {
+        std::cout << "Bridge " << bridge + 1 << " (" << length << "): "
+            << totalTime << " minute(s)\n";
+    });
+    try {
+        if (ends_with(filename, ".yaml")) {
+            YAMLEventCaseParser().parseFile(filename, solver);
+        }
+        else if (filename == "-") {
+            CaseParser().parse(std::cin, solver);
+        }
+        else {
+            std::ifstream in(filename);
+            if (!in) {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+            CaseParser().parse(in, solver);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout.flush();
         std::cerr << "Parse case error: " << e.what() << std::endl;
+        return;
+    }
+    std::cout << "Total crossing time is " << solver.getTotalTime() << " minute(s)" << std::endl;
+}
+
+// Print what each hiker costs the case: the total time without them, and
+// the difference with the total time.
+void run_marginal_costs(const string& filename)
+{
+    vector<Hiker> origHikers;
+    vector<Bridge> bridges;
+    try {
+        YAMLEventCaseParser().parseFile(filename, origHikers, bridges);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Parse case error: " << e.what() << std::endl;
+        return;
+    }
+    CaseAnalysis analysis(bridges, origHikers);
+    vector<CaseChange> changes;
+    for (size_t hiker = 0; hiker < analysis.getHikerCount(); ++hiker) {
+        changes.push_back(CaseChange::removeHiker(hiker));
+    }
+    vector<double> totals = analysis.evaluate(changes);
+    std::ostringstream oss;
+    oss << "Total crossing time is " << analysis.getTotalTime() << " minute(s)\n"
+        << std::left << std::setw(16) << "Hiker" << std::setw(12) << "Speed"
+        << std::setw(12) << "Met at" << std::setw(16) << "Without"
+        << "Marginal cost\n";
+    for (size_t hiker = 0; hiker < analysis.getHikerCount(); ++hiker) {
+        const CaseAnalysis::HikerInfo& info = analysis.getHiker(hiker);
+        oss << std::setw(16) << info.name << std::setw(12) << info.speed << std::setw(12)
+            << (info.arrival == CaseAnalysis::kOriginal ? string("start")
+                : "bridge " + std::to_string(info.arrival + 1));
+        if (totals[hiker] < 0) {
+            oss << "n/a (no original hiker left)\n";
+            continue;
+        }
+        oss << std::setw(16) << totals[hiker] << analysis.getTotalTime() - totals[hiker] << '\n';
+    }
+    string report = oss.str();
+    std::cout.write(report.data(), report.size());
+    std::cout.flush();
+}
+
+// Read events from stdin, one per line, and print the running total after
+// each bridge:
+//   hiker NAME SPEED   a hiker joins (an original hiker before any bridge)
+//   remove NAME        the last hiker named NAME leaves
+//   bridge LENGTH      cross a bridge
+//   reset              start another route
+// Blank lines and lines starting with '#' are skipped. A bad event is
+// reported on stderr and skipped.
+void run_serve(Cache& cache)
+{
+    CrossingSession session(&cache);
+    string line;
+    size_t lineNumber = 0;
+    while (std::getline(std::cin, line)) {
+        ++lineNumber;
+        std::istringstream iss(line);
+        string event;
+        if (!(iss >> event) || event[0] == '#') {
+            continue;
+        }
+        try {
+            string name;
+            double value = 0.0;
+            if (event == "hiker" && iss >> name >> value) {
+                session.addHiker(name, value);
+            }
+            else if (event == "remove" && iss >> name) {
+                if (!session.removeHiker(name)) {
+                    throw std::invalid_argument("No hiker named " + name);
+                }
+            }
+            else if (event == "bridge" && iss >> value) {
+                session.addBridge(value);
+                std::cout << "Bridge " << session.getBridgeCount() << " (" << value << "): "
+                    << session.getTotalTime() << " minute(s)" << std::endl;
+            }
+            else if (event == "reset") {
+                session.reset();
+            }
+            else {
+                throw std::invalid_argument("Unknown event: " + line);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Event error at line " << lineNumber << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+void print_latency_stats(const LatencyStats& stats)
+{
+    std::cerr << stats.requestCount << " request(s) in " << stats.batchCount
+        << " batch(es), p50 " << stats.p50Micros << " us, p99 " << stats.p99Micros
+        << " us" << std::endl;
+}
+
+// Serve cases on a Unix socket (see CaseServer) until SIGINT or SIGTERM,
+// printing the latency of the last 10 seconds when there were requests.
+int run_daemon(const string& socketPath, Cache& cache, size_t threadCount)
+{
+    // Blocked before the server threads start, so that they inherit it and
+    // only sigtimedwait below sees the signals.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    try {
+        CaseServer server(socketPath, threadCount, &cache);
+        std::cerr << "Serving cases at " << socketPath << std::endl;
+        timespec period{10, 0};
+        while (sigtimedwait(&signals, nullptr, &period) < 0) {
+            LatencyStats stats = server.takeLatencyStats();
+            if (stats.requestCount > 0) {
+                print_latency_stats(stats);
+            }
+        }
+        server.stop();
+        print_latency_stats(server.takeLatencyStats());
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// A directory gives its .yaml and .bin files (sorted by name), "@list" gives the
+// files listed one per line in `list`, anything else is a case file.
+void add_case_files(const string& arg, vector<string>& files)
+{
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream list(arg.substr(1));
+        if (!list) {
+            std::cerr << "Cannot read case list: " << arg.substr(1) << std::endl;
+            return;
+        }
+        string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                files.push_back(line);
+            }
+        }
+        return;
+    }
+    struct stat st;
+    DIR* dir = nullptr;
+    if (stat(arg.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ||
+        (dir = opendir(arg.c_str())) == nullptr) {
+        files.push_back(arg);
+        return;
+    }
+    vector<string> dirFiles;
+    while (struct dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (ends_with(name, ".yaml") || ends_with(name, ".bin")) {
+            dirFiles.push_back(arg + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(dirFiles.begin(), dirFiles.end());
+    files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+}
+
+// Parse and solve the cases on a thread pool, one calculator per worker and
+// one shared cache. Results, and the errors logged while parsing, are printed
+// in the order of `files`.
+void run_batch(const vector<string>& files, Cache& cache, size_t threadCount)
+{
+    ThreadPool pool(threadCount);
+    vector<CrossingTimeCalculator> calcs(pool.getThreadCount(),
+        CrossingTimeCalculator(&cache));
+    vector<string> results(files.size());
+    // Not vector<bool>: workers set neighbouring flags at the same time.
+    vector<char> failed(files.size(), false);
+    pool.parallelFor(files.size(), [&](size_t index, size_t worker) {
+        vector<Hiker> origHikers;
+        vector<Bridge> bridges;
+        std::ostringstream log;
+        std::ostringstream oss;
+        oss << files[index] << ": ";
+        double totalTime = 0.0;
+        try {
+            if (ends_with(files[index], ".bin")) {
+                totalTime = calcs[worker].calcCrossingTime(BinaryCase(files[index]));
+            }
+            else {
+                YAMLEventCaseParser(log).parseFile(files[index], origHikers, bridges);
+                totalTime = calcs[worker].calcCrossingTime(bridges, origHikers, false);
+            }
+        }
+        catch (const std::exception& e) {
+            oss << "Parse case error: " << e.what() << '\n';
+            results[index] = log.str() + oss.str();
+            failed[index] = true;
+            return;
+        }
+        oss << "Total crossing time is " << totalTime << " minute(s)\n";
+        results[index] = oss.str();
+    });
+    for (size_t i = 0; i < files.size(); ++i) {
+        (failed[i] ? std::cerr : std::cout) << results[i];
+    }
+    std::cout.flush();
+}
+
+// Solve a file of string cases, one per line, on a thread pool and write
+// one result line per case to `outputFile` (see solve_line_cases).
+int run_line_cases(const string& inputFile, const string& outputFile, Cache& cache,
+    size_t threadCount)
+{
+    try {
+        LineCaseFile input(inputFile);
+        std::ofstream output(outputFile, std::ios::binary);
+        if (!output) {
+            throw std::runtime_error("Cannot open " + outputFile);
+        }
+        ThreadPool pool(threadCount);
+        LineCaseSummary summary = solve_line_cases(input, output, pool, &cache);
+        if (!output) {
+            throw std::runtime_error("Cannot write " + outputFile);
+        }
+        std::cerr << summary.caseCount << " case(s), " << summary.errorCount
+            << " parse error(s)" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Test code
+
+double run_case(const string& strCase, bool verbose=false)
+{
+    vector<Hiker> origHikers;
+    vector<Bridge> bridges;
+    CaseParseError error;
+    if (!FastCaseParser().parse(strCase, origHikers, bridges, error)) {
+        std::cerr << "Parse case error at " << error.position << ": "
+            << error.message << std::endl;
         return -1.0;
     }
     if (verbose) {
         std::cout << "Case: " << strCase << std::endl;
     }
-    Cache cache;
+    // One small table per test case, so each case prints its own hits.
+    Cache cache(64 << 10);
     CrossingTimeCalculator calc(&cache);
     double totalTime = calc.calcCrossingTime(bridges, origHikers, verbose);
     if (verbose) {
@@ -94,14 +428,183 @@ void run_tests()
     }
 }
 
+// Write the stats as JSON (--stats) or as a Chrome trace (--trace).
+void write_stats(const string& filename, const Cache& cache, bool trace)
+{
+    std::ofstream out(filename);
+    if (trace) {
+        Stats::instance().writeTrace(out);
+    }
+    else {
+        CacheStats cacheStats = cache.getStats();
+        Stats::instance().writeJSON(out, &cacheStats);
+    }
+    if (!out) {
+        std::cerr << "Cannot write " << filename << std::endl;
+    }
+}
+
+void print_usage()
+{
+    std::cerr <<
+        "Usage: hiker [--plan-format text|json|csv] [--cache-file path] [case.yaml]\n"
+        "       hiker --parallel [--threads N] [--cache-file path] case.yaml|case.bin\n"
+        "       hiker --marginal case.yaml\n"
+        "       hiker --batch [--threads N] [--cache-file path] case.yaml|dir|@list...\n"
+        "       hiker --stream [--cache-file path] case.yaml|case.txt|-\n"
+        "       hiker --lines [--threads N] [--cache-file path] cases.txt results.txt\n"
+        "       hiker --serve [--cache-file path] < events\n"
+        "       hiker --daemon socket [--threads N] [--cache-file path]\n"
+        "       hiker convert case.yaml case.bin\n"
+        "Any mode also takes --stats stats.json and --trace trace.json.\n"
+        "--threads N: 0 (the default) for one per hardware thread, at most "
+        << kMaxThreadCount << "." << std::endl;
+}
+
+// See print_usage.
 int main(int argc, const char* argv[])
 {
-    if (argc > 1) {
-        string yamlFile = argv[1];
-        run_yaml_case(yamlFile, true);
+    if (argc == 4 && string(argv[1]) == "convert") {
+        return convert_case(argv[2], argv[3]);
+    }
+    vector<string> caseArgs;
+    string cacheFile;
+    string statsFile;
+    string traceFile;
+    PlanFormat planFormat = PlanFormat::Text;
+    bool batch = false;
+    bool stream = false;
+    bool serve = false;
+    bool parallel = false;
+    bool marginal = false;
+    bool lines = false;
+    string daemonSocket;
+    size_t threadCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--plan-format" && i + 1 < argc) {
+            if (!parse_plan_format(argv[++i], planFormat)) {
+                std::cerr << "Unknown plan format: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--cache-file" && i + 1 < argc) {
+            cacheFile = argv[++i];
+        }
+        else if (arg == "--stats" && i + 1 < argc) {
+            statsFile = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        }
+        else if (arg == "--batch") {
+            batch = true;
+        }
+        else if (arg == "--stream") {
+            stream = true;
+        }
+        else if (arg == "--daemon" && i + 1 < argc) {
+            daemonSocket = argv[++i];
+        }
+        else if (arg == "--lines") {
+            lines = true;
+        }
+        else if (arg == "--marginal") {
+            marginal = true;
+        }
+        else if (arg == "--parallel") {
+            parallel = true;
+        }
+        else if (arg == "--serve") {
+            serve = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            if (!parse_thread_count(argv[++i], threadCount)) {
+                std::cerr << "Bad thread count: " << argv[i] << std::endl;
+                print_usage();
+                return 1;
+            }
+        }
+        else {
+            caseArgs.push_back(arg);
+        }
+    }
+    if (!statsFile.empty() || !traceFile.empty()) {
+        if (!Stats::isCompiledIn()) {
+            std::cerr << "Stats are compiled out, build with STATS=1" << std::endl;
+        }
+        Stats::instance().setEnabled(true);
+        Stats::instance().setTracing(!traceFile.empty());
+    }
+    Cache cache;
+    std::unique_ptr<PersistentCache> persistentCache;
+    if (!cacheFile.empty()) {
+        // Carry on without it if it cannot be used.
+        try {
+            persistentCache.reset(new PersistentCache(cacheFile));
+            cache.setPersistentCache(persistentCache.get());
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Cache file error: " << e.what() << std::endl;
+        }
+    }
+    if (batch) {
+        vector<string> files;
+        for (auto& caseArg : caseArgs) {
+            add_case_files(caseArg, files);
+        }
+        run_batch(files, cache, threadCount);
+    }
+    else if (!daemonSocket.empty()) {
+        int status = run_daemon(daemonSocket, cache, threadCount);
+        if (status != 0) {
+            return status;
+        }
+    }
+    else if (lines) {
+        if (caseArgs.size() != 2) {
+            std::cerr << "Usage: hiker --lines cases.txt results.txt" << std::endl;
+            return 1;
+        }
+        int status = run_line_cases(caseArgs[0], caseArgs[1], cache, threadCount);
+        if (status != 0) {
+            return status;
+        }
+    }
+    else if (marginal) {
+        for (auto& caseArg : caseArgs) {
+            run_marginal_costs(caseArg);
+        }
+    }
+    else if (serve) {
+        run_serve(cache);
+    }
+    else if (stream) {
+        for (auto& caseArg : caseArgs) {
+            run_streaming_case(caseArg, cache);
+        }
+    }
+    else if (!caseArgs.empty()) {
+        // One case, its bridges split across the threads if --parallel.
+        std::unique_ptr<ThreadPool> pool;
+        if (parallel) {
+            pool.reset(new ThreadPool(threadCount));
+        }
+        if (ends_with(caseArgs.back(), ".bin")) {
+            run_binary_case(caseArgs.back(), cache, pool.get());
+        }
+        else {
+            run_yaml_case(caseArgs.back(), cache, !parallel, planFormat, pool.get());
+        }
     }
     else {
         run_tests();
     }
+    if (!statsFile.empty()) {
+        write_stats(statsFile, cache, false);
+    }
+    if (!traceFile.empty()) {
+        write_stats(traceFile, cache, true);
+    }
     return 0;
 }
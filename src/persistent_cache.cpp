@@ -0,0 +1,149 @@
+#include "persistent_cache.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+const uint64_t kMagic = 0x4548434143524b48ull; // "HKRCACHE"
+const uint32_t kVersion = 1;
+
+size_t ceil_power_of_two(size_t value)
+{
+    size_t power = 1;
+    while (power < value) {
+        power *= 2;
+    }
+    return power;
+}
+
+std::runtime_error cache_file_error(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + ": " + path + " (" + strerror(errno) + ")");
+}
+
+} // namespace
+
+const size_t PersistentCache::kDefaultSlotCount;
+const size_t PersistentCache::kProbeLimit;
+
+PersistentCache::PersistentCache(const std::string& path, size_t slotCount)
+    : fd_(-1), mapping_(MAP_FAILED), mappingSize_(0), slots_(nullptr), slotCount_(0) {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw cache_file_error("Cannot open cache file", path);
+    }
+    // Only one process lays out a new file.
+    flock(fd_, LOCK_EX);
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        flock(fd_, LOCK_UN);
+        close(fd_);
+        throw cache_file_error("Cannot stat cache file", path);
+    }
+    Header header;
+    if (st.st_size == 0) {
+        header = Header{kMagic, kVersion, sizeof(Slot), ceil_power_of_two(slotCount)};
+        // The slots are zero, that is empty, and the file is sparse.
+        if (ftruncate(fd_, sizeof(Header) + header.slotCount * sizeof(Slot)) != 0 ||
+            pwrite(fd_, &header, sizeof(header), 0) != sizeof(header)) {
+            flock(fd_, LOCK_UN);
+            close(fd_);
+            throw cache_file_error("Cannot create cache file", path);
+        }
+    }
+    else if (pread(fd_, &header, sizeof(header), 0) != sizeof(header)) {
+        flock(fd_, LOCK_UN);
+        close(fd_);
+        throw cache_file_error("Cannot read cache file", path);
+    }
+    flock(fd_, LOCK_UN);
+    mappingSize_ = sizeof(Header) + header.slotCount * sizeof(Slot);
+    if (header.magic != kMagic || header.version != kVersion ||
+        header.slotSize != sizeof(Slot) || header.slotCount == 0 ||
+        (header.slotCount & (header.slotCount - 1)) != 0 ||
+        static_cast<size_t>(st.st_size > 0 ? st.st_size : mappingSize_) != mappingSize_) {
+        close(fd_);
+        throw std::runtime_error("Not a hiker cache file: " + path);
+    }
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        close(fd_);
+        throw cache_file_error("Cannot map cache file", path);
+    }
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(Header));
+    slotCount_ = header.slotCount;
+}
+
+PersistentCache::~PersistentCache() {
+    if (mapping_ != MAP_FAILED) {
+        munmap(mapping_, mappingSize_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+uint64_t PersistentCache::getTag(const GroupKey& key) {
+    uint64_t tag = key.origHash ^ (key.additionalHash * 0x9e3779b97f4a7c15ull);
+    return tag ? tag : 1;
+}
+
+double PersistentCache::getTime(const GroupKey& key) const {
+    uint64_t tag = getTag(key);
+    for (size_t i = 0; i < kProbeLimit; ++i) {
+        Slot& slot = slots_[(tag + i) & (slotCount_ - 1)];
+        uint64_t slotTag = __atomic_load_n(&slot.tag, __ATOMIC_ACQUIRE);
+        if (slotTag == 0) {
+            break;
+        }
+        if (slotTag != tag) {
+            continue;
+        }
+        uint64_t bits = __atomic_load_n(&slot.perFeetTimeBits, __ATOMIC_ACQUIRE);
+        if (bits != 0 &&
+            __atomic_load_n(&slot.origHash, __ATOMIC_RELAXED) == key.origHash &&
+            __atomic_load_n(&slot.additionalHash, __ATOMIC_RELAXED) == key.additionalHash) {
+            double perFeetTime;
+            std::memcpy(&perFeetTime, &bits, sizeof(perFeetTime));
+            return perFeetTime;
+        }
+    }
+    return -1.0;
+}
+
+bool PersistentCache::setTime(const GroupKey& key, double perFeetTime) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &perFeetTime, sizeof(bits));
+    if (bits == 0) {
+        return false;
+    }
+    uint64_t tag = getTag(key);
+    for (size_t i = 0; i < kProbeLimit; ++i) {
+        Slot& slot = slots_[(tag + i) & (slotCount_ - 1)];
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n(&slot.tag, &expected, tag, false,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&slot.origHash, key.origHash, __ATOMIC_RELAXED);
+            __atomic_store_n(&slot.additionalHash, key.additionalHash, __ATOMIC_RELAXED);
+            __atomic_store_n(&slot.perFeetTimeBits, bits, __ATOMIC_RELEASE);
+            return true;
+        }
+        // Already stored (or being stored) by someone else: same result.
+        if (expected == tag &&
+            __atomic_load_n(&slot.origHash, __ATOMIC_RELAXED) == key.origHash &&
+            __atomic_load_n(&slot.additionalHash, __ATOMIC_RELAXED) == key.additionalHash) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,225 @@
+#include "plan_writer.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "crossing_plan.h"
+#include "stats.h"
+
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Hiker names of a bridge by plan id: original hikers, then the accumulated
+// additional hikers (only built if a step needs them).
+class Roster {
+public:
+    Roster(const vector<Hiker>& origHikers, const Bridge& bridge)
+        : origHikers_(origHikers), bridge_(bridge), loaded_(false) {
+    }
+
+    const string& getName(uint32_t id) {
+        if (id < origHikers_.size()) {
+            return origHikers_[id].getName();
+        }
+        if (!loaded_) {
+            additionalHikers_ = bridge_.getAdditionalHikers();
+            loaded_ = true;
+        }
+        return additionalHikers_[id - origHikers_.size()].getName();
+    }
+
+private:
+    const vector<Hiker>& origHikers_;
+    const Bridge& bridge_;
+    vector<Hiker> additionalHikers_;
+    bool loaded_;
+};
+
+// Same text as `std::ostream << double` with the default precision.
+void append_number(string& out, double value)
+{
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%g", value);
+    out.append(buffer, length);
+}
+
+void append_json_string(string& out, const string& str)
+{
+    out += '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void append_csv_field(string& out, const string& str)
+{
+    if (str.find_first_of(",\"\n") == string::npos) {
+        out += str;
+        return;
+    }
+    out += '"';
+    for (char c : str) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+bool parse_plan_format(const string& str, PlanFormat& format)
+{
+    if (str == "text") {
+        format = PlanFormat::Text;
+    }
+    else if (str == "json") {
+        format = PlanFormat::JSON;
+    }
+    else if (str == "csv") {
+        format = PlanFormat::CSV;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void PlanWriter::write(const CrossingPlan& plan, const vector<Hiker>& origHikers,
+    const vector<Bridge>& bridges, string& out) const {
+    HIKER_STATS_TIMER(StatPhase::Report);
+    switch (format_) {
+    case PlanFormat::JSON:
+        writeJSON(plan, origHikers, bridges, out);
+        break;
+    case PlanFormat::CSV:
+        writeCSV(plan, origHikers, bridges, out);
+        break;
+    default:
+        writeText(plan, origHikers, bridges, out);
+        break;
+    }
+}
+
+void PlanWriter::writeText(const CrossingPlan& plan, const vector<Hiker>& origHikers,
+    const vector<Bridge>& bridges, string& out) const {
+    auto& steps = plan.getSteps();
+    auto& bridgePlans = plan.getBridges();
+    for (size_t i = 0; i < bridgePlans.size() && i < bridges.size(); ++i) {
+        auto& bridgePlan = bridgePlans[i];
+        out += "Bridge (";
+        append_number(out, bridgePlan.length);
+        out += ")\n";
+        if (bridgePlan.cacheHit) {
+            out += "Hit cache for hiker count ";
+            out += std::to_string(bridgePlan.hikerCount);
+            out += " at bridge with length ";
+            append_number(out, bridgePlan.length);
+            out += '\n';
+            continue;
+        }
+        Roster roster(origHikers, bridges[i]);
+        for (size_t j = bridgePlan.stepBegin; j < bridgePlan.stepEnd; ++j) {
+            auto& step = steps[j];
+            out += roster.getName(step.first);
+            if (step.second == PlanStep::kNone) {
+                out += " crosses\n";
+                continue;
+            }
+            out += ',';
+            out += roster.getName(step.second);
+            out += " cross";
+            if (step.returner != PlanStep::kNone) {
+                out += ", ";
+                out += roster.getName(step.returner);
+                out += " returns";
+            }
+            out += '\n';
+        }
+    }
+}
+
+void PlanWriter::writeJSON(const CrossingPlan& plan, const vector<Hiker>& origHikers,
+    const vector<Bridge>& bridges, string& out) const {
+    auto& steps = plan.getSteps();
+    auto& bridgePlans = plan.getBridges();
+    out += "{\"bridges\":[";
+    for (size_t i = 0; i < bridgePlans.size() && i < bridges.size(); ++i) {
+        auto& bridgePlan = bridgePlans[i];
+        out += i ? ",\n{\"length\":" : "\n{\"length\":";
+        append_number(out, bridgePlan.length);
+        out += ",\"hikers\":";
+        out += std::to_string(bridgePlan.hikerCount);
+        out += bridgePlan.cacheHit ? ",\"cacheHit\":true" : ",\"cacheHit\":false";
+        out += ",\"steps\":[";
+        Roster roster(origHikers, bridges[i]);
+        for (size_t j = bridgePlan.stepBegin; j < bridgePlan.stepEnd; ++j) {
+            auto& step = steps[j];
+            out += j > bridgePlan.stepBegin ? ",{\"cross\":[" : "{\"cross\":[";
+            append_json_string(out, roster.getName(step.first));
+            if (step.second != PlanStep::kNone) {
+                out += ',';
+                append_json_string(out, roster.getName(step.second));
+            }
+            out += "],\"returns\":";
+            if (step.returner != PlanStep::kNone) {
+                append_json_string(out, roster.getName(step.returner));
+            }
+            else {
+                out += "null";
+            }
+            out += '}';
+        }
+        out += "]}";
+    }
+    out += "\n]}\n";
+}
+
+void PlanWriter::writeCSV(const CrossingPlan& plan, const vector<Hiker>& origHikers,
+    const vector<Bridge>& bridges, string& out) const {
+    auto& steps = plan.getSteps();
+    auto& bridgePlans = plan.getBridges();
+    out += "bridge,length,step,first,second,returner\n";
+    for (size_t i = 0; i < bridgePlans.size() && i < bridges.size(); ++i) {
+        auto& bridgePlan = bridgePlans[i];
+        Roster roster(origHikers, bridges[i]);
+        for (size_t j = bridgePlan.stepBegin; j < bridgePlan.stepEnd; ++j) {
+            auto& step = steps[j];
+            out += std::to_string(i);
+            out += ',';
+            append_number(out, bridgePlan.length);
+            out += ',';
+            out += std::to_string(j - bridgePlan.stepBegin);
+            out += ',';
+            append_csv_field(out, roster.getName(step.first));
+            out += ',';
+            if (step.second != PlanStep::kNone) {
+                append_csv_field(out, roster.getName(step.second));
+            }
+            out += ',';
+            if (step.returner != PlanStep::kNone) {
+                append_csv_field(out, roster.getName(step.returner));
+            }
+            out += '\n';
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include "simd_kernels.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HIKER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+double sum_max_scalar(const double* values, size_t count, double lead)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += fmax(lead, values[i]);
+    }
+    return sum;
+}
+
+size_t count_less_scalar(const double* values, size_t count, double threshold)
+{
+    size_t less = 0;
+    for (size_t i = 0; i < count; ++i) {
+        less += values[i] < threshold;
+    }
+    return less;
+}
+
+size_t find_byte_scalar(const char* data, size_t size, char byte)
+{
+    size_t i = 0;
+    while (i < size && data[i] != byte) {
+        ++i;
+    }
+    return i;
+}
+
+#ifdef HIKER_X86_SIMD
+
+// GCC's intrinsics headers trip these warnings when inlined into target
+// functions (the "undefined" vectors they use on purpose).
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx2")))
+double sum_max_avx2(const double* values, size_t count, double lead)
+{
+    __m256d leadVec = _mm256_set1_pd(lead);
+    // Two accumulators to hide the add latency.
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_pd(sum0, _mm256_max_pd(leadVec, _mm256_loadu_pd(values + i)));
+        sum1 = _mm256_add_pd(sum1, _mm256_max_pd(leadVec, _mm256_loadu_pd(values + i + 4)));
+    }
+    if (i + 4 <= count) {
+        sum0 = _mm256_add_pd(sum0, _mm256_max_pd(leadVec, _mm256_loadu_pd(values + i)));
+        i += 4;
+    }
+    sum0 = _mm256_add_pd(sum0, sum1);
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum0);
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    return sum + sum_max_scalar(values + i, count - i, lead);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t count_less_avx2(const double* values, size_t count, double threshold)
+{
+    __m256d thresholdVec = _mm256_set1_pd(threshold);
+    size_t less = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(values + i), thresholdVec, _CMP_LT_OQ);
+        less += __builtin_popcount(_mm256_movemask_pd(mask));
+    }
+    return less + count_less_scalar(values + i, count - i, threshold);
+}
+
+__attribute__((target("avx512f")))
+double sum_max_avx512(const double* values, size_t count, double lead)
+{
+    __m512d leadVec = _mm512_set1_pd(lead);
+    __m512d sum0 = _mm512_setzero_pd();
+    __m512d sum1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        sum0 = _mm512_add_pd(sum0, _mm512_max_pd(leadVec, _mm512_loadu_pd(values + i)));
+        sum1 = _mm512_add_pd(sum1, _mm512_max_pd(leadVec, _mm512_loadu_pd(values + i + 8)));
+    }
+    if (i + 8 <= count) {
+        sum0 = _mm512_add_pd(sum0, _mm512_max_pd(leadVec, _mm512_loadu_pd(values + i)));
+        i += 8;
+    }
+    if (i < count) {
+        // The masked out lanes add zero.
+        __mmask8 tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+        sum1 = _mm512_add_pd(sum1,
+            _mm512_maskz_max_pd(tail, leadVec, _mm512_maskz_loadu_pd(tail, values + i)));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+}
+
+__attribute__((target("avx512f,popcnt")))
+size_t count_less_avx512(const double* values, size_t count, double threshold)
+{
+    __m512d thresholdVec = _mm512_set1_pd(threshold);
+    size_t less = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __mmask8 mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), thresholdVec, _CMP_LT_OQ);
+        less += __builtin_popcount(mask);
+    }
+    if (i < count) {
+        __mmask8 tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+        __mmask8 mask = _mm512_mask_cmp_pd_mask(tail, _mm512_maskz_loadu_pd(tail, values + i),
+            thresholdVec, _CMP_LT_OQ);
+        less += __builtin_popcount(mask);
+    }
+    return less;
+}
+
+__attribute__((target("avx2,bmi")))
+size_t find_byte_avx2(const char* data, size_t size, char byte)
+{
+    __m256i byteVec = _mm256_set1_epi8(byte);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, byteVec)));
+        if (mask != 0) {
+            return i + _tzcnt_u32(mask);
+        }
+    }
+    return i + find_byte_scalar(data + i, size - i, byte);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+SimdLevel detect_simd_level()
+{
+#ifdef HIKER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+} // namespace
+
+SimdLevel get_simd_level()
+{
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+double sum_max_per_feet_time(const double* perFeetTimes, size_t count,
+    double leadPerFeetTime)
+{
+    return sum_max_per_feet_time(perFeetTimes, count, leadPerFeetTime, get_simd_level());
+}
+
+double sum_max_per_feet_time(const double* perFeetTimes, size_t count,
+    double leadPerFeetTime, SimdLevel level)
+{
+#ifdef HIKER_X86_SIMD
+    if (level == SimdLevel::AVX512) {
+        return sum_max_avx512(perFeetTimes, count, leadPerFeetTime);
+    }
+    if (level == SimdLevel::AVX2) {
+        return sum_max_avx2(perFeetTimes, count, leadPerFeetTime);
+    }
+#else
+    (void)level;
+#endif
+    return sum_max_scalar(perFeetTimes, count, leadPerFeetTime);
+}
+
+size_t count_speed_slower_than(const double* speeds, size_t count,
+    double thresholdSpeed)
+{
+    return count_speed_slower_than(speeds, count, thresholdSpeed, get_simd_level());
+}
+
+size_t count_speed_slower_than(const double* speeds, size_t count,
+    double thresholdSpeed, SimdLevel level)
+{
+#ifdef HIKER_X86_SIMD
+    if (level == SimdLevel::AVX512) {
+        return count_less_avx512(speeds, count, thresholdSpeed);
+    }
+    if (level == SimdLevel::AVX2) {
+        return count_less_avx2(speeds, count, thresholdSpeed);
+    }
+#else
+    (void)level;
+#endif
+    return count_less_scalar(speeds, count, thresholdSpeed);
+}
+
+size_t find_byte(const char* data, size_t size, char byte)
+{
+    return find_byte(data, size, byte, get_simd_level());
+}
+
+size_t find_byte(const char* data, size_t size, char byte, SimdLevel level)
+{
+#ifdef HIKER_X86_SIMD
+    if (level != SimdLevel::Scalar) {
+        return find_byte_avx2(data, size, byte);
+    }
+#else
+    (void)level;
+#endif
+    return find_byte_scalar(data, size, byte);
+}
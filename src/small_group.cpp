@@ -0,0 +1,114 @@
+#include "small_group.h"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "stats.h"
+
+
+namespace {
+
+// Hikers other than the two fastest original hikers.
+const size_t kMaxOtherCount = kMaxSmallGroupSize - 2;
+
+struct OtherHikers {
+    double speeds[kMaxOtherCount];
+    double perFeetTimes[kMaxOtherCount];
+};
+
+// Crossing time of the hiker at `index` of the other hikers: the first
+// `restCount` cross with the fastest, who comes back; the others cross in
+// pairs and only the slower of each pair (odd offsets) counts.
+inline double other_hiker_time(size_t index, size_t restCount, double perFeetTime,
+    double leadPerFeetTime)
+{
+    if (index < restCount) {
+        return leadPerFeetTime + std::fmax(leadPerFeetTime, perFeetTime);
+    }
+    return ((index - restCount) & 1) ? perFeetTime : 0.0;
+}
+
+template <size_t... I>
+double small_group_kernel_unrolled(const OtherHikers& others, double leadPerFeetTime,
+    double secondPerFeetTime, double thresholdSpeed, std::index_sequence<I...>)
+{
+    constexpr size_t kCount = sizeof...(I);
+    size_t slowCount = (size_t{0} + ... +
+        static_cast<size_t>(others.speeds[I] < thresholdSpeed));
+    size_t pairCount = slowCount >> 1;
+    HIKER_STATS_ADD(StatCounter::SlowPairs, pairCount);
+    [[maybe_unused]] size_t restCount = kCount - pairCount * 2;
+    // Each pair: fastest and second cross, fastest returns, the pair
+    // crosses, second returns. Last, fastest and second cross.
+    double perFeetTime = (leadPerFeetTime + secondPerFeetTime * 2) * pairCount
+        + secondPerFeetTime;
+    return perFeetTime + (0.0 + ... +
+        other_hiker_time(I, restCount, others.perFeetTimes[I], leadPerFeetTime));
+}
+
+typedef double (*SmallGroupKernel)(const OtherHikers& others, double leadPerFeetTime,
+    double secondPerFeetTime, double thresholdSpeed);
+
+template <size_t Count>
+double small_group_kernel(const OtherHikers& others, double leadPerFeetTime,
+    double secondPerFeetTime, double thresholdSpeed)
+{
+    return small_group_kernel_unrolled(others, leadPerFeetTime, secondPerFeetTime,
+        thresholdSpeed, std::make_index_sequence<Count>());
+}
+
+template <size_t... Count>
+constexpr std::array<SmallGroupKernel, sizeof...(Count)> make_small_group_kernels(
+    std::index_sequence<Count...>)
+{
+    return {{&small_group_kernel<Count>...}};
+}
+
+// By the number of other hikers, 0 to kMaxOtherCount.
+constexpr auto kSmallGroupKernels = make_small_group_kernels(
+    std::make_index_sequence<kMaxOtherCount + 1>());
+
+// Merge the original hikers after the second and the additional hikers by
+// speed in descending order. Return the count.
+size_t merge_other_hikers(const HikerSpan& hikers, const HikerSpan& additionalHikers,
+    OtherHikers& others)
+{
+    size_t index = 2;
+    size_t additionalIndex = 0;
+    size_t count = 0;
+    while (index < hikers.size && additionalIndex < additionalHikers.size) {
+        if (hikers.speeds[index] >= additionalHikers.speeds[additionalIndex]) {
+            others.speeds[count] = hikers.speeds[index];
+            others.perFeetTimes[count++] = hikers.perFeetTimes[index++];
+        }
+        else {
+            others.speeds[count] = additionalHikers.speeds[additionalIndex];
+            others.perFeetTimes[count++] = additionalHikers.perFeetTimes[additionalIndex++];
+        }
+    }
+    for (; index < hikers.size; ++index, ++count) {
+        others.speeds[count] = hikers.speeds[index];
+        others.perFeetTimes[count] = hikers.perFeetTimes[index];
+    }
+    for (; additionalIndex < additionalHikers.size; ++additionalIndex, ++count) {
+        others.speeds[count] = additionalHikers.speeds[additionalIndex];
+        others.perFeetTimes[count] = additionalHikers.perFeetTimes[additionalIndex];
+    }
+    return count;
+}
+
+} // namespace
+
+double calc_small_group_per_feet_time(const HikerSpan& hikers,
+    const HikerSpan& additionalHikers)
+{
+    assert(is_small_group(hikers.size, additionalHikers.size));
+    OtherHikers others;
+    size_t count = merge_other_hikers(hikers, additionalHikers, others);
+    // Same as CrossingTimeCalculator::calcThresholdSpeed.
+    double thresholdSpeed = 1.0 / (2.0/hikers.speeds[1] - 1.0/hikers.speeds[0]);
+    return kSmallGroupKernels[count](others, hikers.perFeetTimes[0], hikers.perFeetTimes[1],
+        thresholdSpeed);
+}
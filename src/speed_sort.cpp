@@ -0,0 +1,125 @@
+#include "speed_sort.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+using std::vector;
+
+namespace {
+
+const int kDigitBits = 8;
+const int kDigitCount = 64 / kDigitBits;
+const size_t kBucketCount = size_t{1} << kDigitBits;
+
+const size_t kInsertionSortRun = 16;
+
+// Unsigned key that sorts in ascending order as the speed descends: flip
+// all bits of negative numbers and the sign bit of the others to get the
+// ascending order of doubles, then invert it.
+inline uint64_t descending_key(double speed)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &speed, sizeof(bits));
+    uint64_t ascending = (bits >> 63) ? ~bits : bits ^ (uint64_t{1} << 63);
+    return ~ascending;
+}
+
+// Stable merge sort: insertion sorted runs, then merges of doubling width
+// between `rows` and the scratch rows.
+void merge_sort_rows(const double* speeds, vector<uint32_t>& rows, vector<uint32_t>& scratch)
+{
+    auto faster = [speeds](uint32_t lhs, uint32_t rhs) { return speeds[lhs] > speeds[rhs]; };
+    size_t count = rows.size();
+    for (size_t begin = 0; begin < count; begin += kInsertionSortRun) {
+        size_t end = std::min(count, begin + kInsertionSortRun);
+        for (size_t i = begin + 1; i < end; ++i) {
+            uint32_t row = rows[i];
+            size_t j = i;
+            for (; j > begin && faster(row, rows[j - 1]); --j) {
+                rows[j] = rows[j - 1];
+            }
+            rows[j] = row;
+        }
+    }
+    scratch.resize(count);
+    for (size_t width = kInsertionSortRun; width < count; width *= 2) {
+        for (size_t begin = 0; begin < count; begin += 2 * width) {
+            size_t middle = std::min(count, begin + width);
+            size_t end = std::min(count, begin + 2 * width);
+            std::merge(rows.begin() + begin, rows.begin() + middle, rows.begin() + middle,
+                rows.begin() + end, scratch.begin() + begin, faster);
+        }
+        rows.swap(scratch);
+    }
+}
+
+} // namespace
+
+void radix_sort_rows_by_speed(const double* speeds, vector<uint32_t>& rows)
+{
+    SpeedSortBuffers buffers;
+    radix_sort_rows_by_speed(speeds, rows, buffers);
+}
+
+void radix_sort_rows_by_speed(const double* speeds, vector<uint32_t>& rows,
+    SpeedSortBuffers& buffers)
+{
+    size_t count = rows.size();
+    vector<SpeedSortKey>& keyed = buffers.keys;
+    vector<SpeedSortKey>& buffer = buffers.scratchKeys;
+    keyed.resize(count);
+    buffer.resize(count);
+    // All histograms in one read of the keys.
+    vector<size_t>& histograms = buffers.histograms;
+    histograms.assign(kDigitCount * kBucketCount, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = descending_key(speeds[rows[i]]);
+        keyed[i] = SpeedSortKey{key, rows[i]};
+        for (int digit = 0; digit < kDigitCount; ++digit) {
+            ++histograms[digit * kBucketCount + ((key >> (digit * kDigitBits)) & (kBucketCount - 1))];
+        }
+    }
+    for (int digit = 0; digit < kDigitCount; ++digit) {
+        size_t* histogram = &histograms[digit * kBucketCount];
+        // A digit shared by all keys (e.g. the exponent of speeds of the
+        // same scale) does not reorder anything.
+        if (std::find(histogram, histogram + kBucketCount, count) != histogram + kBucketCount) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+            size_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        int shift = digit * kDigitBits;
+        for (auto& item : keyed) {
+            buffer[histogram[(item.key >> shift) & (kBucketCount - 1)]++] = item;
+        }
+        keyed.swap(buffer);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        rows[i] = keyed[i].row;
+    }
+}
+
+void sort_rows_by_speed(const double* speeds, vector<uint32_t>& rows)
+{
+    SpeedSortBuffers buffers;
+    sort_rows_by_speed(speeds, rows, buffers);
+}
+
+void sort_rows_by_speed(const double* speeds, vector<uint32_t>& rows,
+    SpeedSortBuffers& buffers)
+{
+    // Grown whichever sort runs, so that the next sort of up to this many
+    // rows does not allocate either way.
+    buffers.scratchRows.reserve(rows.size());
+    if (rows.size() >= kRadixSortMinCount) {
+        radix_sort_rows_by_speed(speeds, rows, buffers);
+        return;
+    }
+    // std::stable_sort would allocate its own buffer each time.
+    merge_sort_rows(speeds, rows, buffers.scratchRows);
+}
@@ -0,0 +1,112 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+
+#include "cache.h"
+
+
+namespace {
+
+const char* const kPhaseNames[kStatPhaseCount] = {"parse", "sort", "solve", "report"};
+const char* const kCounterNames[kStatCounterCount] = {
+    "bridges", "hikers_processed", "slow_pairs"};
+
+// Small ids for the trace, in the order threads first record a span.
+uint32_t thread_index()
+{
+    static std::atomic<uint32_t> nextIndex{0};
+    thread_local uint32_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+} // namespace
+
+Stats Stats::instance_;
+
+bool Stats::isCompiledIn() {
+#ifdef HIKER_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t Stats::now() {
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count() + 1;
+}
+
+void Stats::addSpan(StatPhase phase, const char* name, int64_t arg,
+    uint64_t begin, uint64_t end) {
+    size_t index = static_cast<size_t>(phase);
+    times_[index].fetch_add(end - begin, std::memory_order_relaxed);
+    spans_[index].fetch_add(1, std::memory_order_relaxed);
+    if (isTracing()) {
+        std::lock_guard<std::mutex> lock(traceMutex_);
+        trace_.push_back({name ? name : kPhaseNames[index], arg, begin, end - begin,
+            thread_index()});
+    }
+}
+
+void Stats::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kStatPhaseCount; ++i) {
+        times_[i].store(0, std::memory_order_relaxed);
+        spans_[i].store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    trace_.clear();
+}
+
+void Stats::writeJSON(std::ostream& out, const CacheStats* cacheStats) const {
+    out << "{\"enabled\":" << (isCompiledIn() && isEnabled() ? "true" : "false")
+        << ",\"phases\":{";
+    for (size_t i = 0; i < kStatPhaseCount; ++i) {
+        StatPhase phase = static_cast<StatPhase>(i);
+        out << (i ? "," : "") << "\"" << kPhaseNames[i] << "\":{\"seconds\":"
+            << getTime(phase) * 1e-9 << ",\"spans\":" << getSpanCount(phase) << "}";
+    }
+    out << "},\"counters\":{";
+    for (size_t i = 0; i < kStatCounterCount; ++i) {
+        out << (i ? "," : "") << "\"" << kCounterNames[i] << "\":"
+            << getCount(static_cast<StatCounter>(i));
+    }
+    out << "}";
+    if (cacheStats) {
+        out << ",\"cache\":{\"hits\":" << cacheStats->hits
+            << ",\"persistent_hits\":" << cacheStats->persistentHits
+            << ",\"misses\":" << cacheStats->misses
+            << ",\"insertions\":" << cacheStats->insertions
+            << ",\"evictions\":" << cacheStats->evictions << "}";
+    }
+    out << "}\n";
+}
+
+void Stats::writeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    uint64_t origin = 0;
+    if (!trace_.empty()) {
+        origin = std::min_element(trace_.begin(), trace_.end(),
+            [](const TraceEvent& lhs, const TraceEvent& rhs) {
+                return lhs.begin < rhs.begin;
+            })->begin;
+    }
+    // Complete events, times in microseconds.
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < trace_.size(); ++i) {
+        auto& event = trace_[i];
+        out << (i ? ",\n" : "\n") << "{\"name\":\"" << event.name
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << (event.begin - origin) * 1e-3
+            << ",\"dur\":" << event.duration * 1e-3;
+        if (event.arg >= 0) {
+            out << ",\"args\":{\"index\":" << event.arg << "}";
+        }
+        out << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
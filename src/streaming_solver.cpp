@@ -0,0 +1,51 @@
+#include "streaming_solver.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "hiker.h"
+#include "stats.h"
+
+
+using std::vector;
+
+void StreamingSolver::onOriginalHikers(const vector<Hiker>& origHikers) {
+    if (origHikers.empty()) {
+        throw std::invalid_argument("Case format error: No original hiker");
+    }
+    for (auto& hiker : origHikers) {
+        group_.addOriginalHiker(hiker.getSpeed());
+        fingerprint_.addOriginalHiker(hiker.getSpeed());
+    }
+    updatePerFeetTime();
+}
+
+void StreamingSolver::onBridge(double length, const vector<Hiker>& newHikers) {
+    HIKER_STATS_BRIDGE(bridgeCount_);
+    if (!newHikers.empty()) {
+        for (auto& hiker : newHikers) {
+            group_.addAdditionalHiker(hiker.getSpeed());
+            fingerprint_.addAdditionalHiker(hiker.getSpeed());
+        }
+        updatePerFeetTime();
+    }
+    HIKER_STATS_ADD(StatCounter::Bridges, 1);
+    HIKER_STATS_ADD(StatCounter::HikersProcessed, group_.getHikerCount());
+    totalTime_ += perFeetTime_ * length;
+    if (listener_) {
+        listener_(bridgeCount_, length, totalTime_);
+    }
+    ++bridgeCount_;
+}
+
+void StreamingSolver::reset() {
+    group_.clear();
+    fingerprint_ = GroupFingerprint();
+    perFeetTime_ = 0.0;
+    totalTime_ = 0.0;
+    bridgeCount_ = 0;
+}
+
+void StreamingSolver::updatePerFeetTime() {
+    perFeetTime_ = group_.calcPerFeetTime(cache_, fingerprint_.getKey());
+}
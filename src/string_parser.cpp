@@ -2,11 +2,15 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 #include "hiker.h"
 #include "bridge.h"
+#include "case_handler.h"
+#include "hiker_pool.h"
 #include "utils.h"
+#include "stats.h"
 
 
 using std::string;
@@ -18,22 +22,59 @@ using std::vector;
 // Example: "A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15"
 void CaseParser::parse(const string& strCase,
     vector<Hiker>& origHikers, vector<Bridge>& bridges) {
+    HIKER_STATS_TIMER(StatPhase::Parse);
     auto items = split(strCase, ';');
     if (items.size() < 2) { // No bridge
         throw std::invalid_argument("Case format error: No bridge");
     }
     parseHikers(items[0], origHikers);
     sort_hikers(origHikers);
-    vector<Hiker> additionalHikers;
+    // All bridges share the pool of additional hikers.
+    auto additionalHikers = std::make_shared<HikerPool>();
     for (size_t i = 1; i < items.size(); ++i) {
         double length = 0.0;
-        size_t size = additionalHikers.size();
-        parseBridge(items[i], length, additionalHikers);
-        // New additional hiker(s) are added, need sort.
-        if (additionalHikers.size() > size) {
-            sort_hikers(additionalHikers);
-        }
-        bridges.emplace_back(Bridge(length, additionalHikers));
+        size_t size = additionalHikers->size();
+        parseBridge(items[i], length, *additionalHikers);
+        bridges.emplace_back(Bridge(length, additionalHikers, size, additionalHikers->size()));
+    }
+    additionalHikers->sortBySpeed();
+}
+
+namespace {
+
+void trim(string& str)
+{
+    const char* whitespace = " \t\r\n";
+    size_t begin = str.find_first_not_of(whitespace);
+    if (begin == string::npos) {
+        str.clear();
+        return;
+    }
+    str.erase(str.find_last_not_of(whitespace) + 1);
+    str.erase(0, begin);
+}
+
+} // namespace
+
+void CaseParser::parse(std::istream& in, CaseHandler& handler) {
+    string item;
+    std::getline(in, item, ';');
+    trim(item);
+    vector<Hiker> hikers;
+    parseHikers(item, hikers);
+    sort_hikers(hikers);
+    handler.onOriginalHikers(hikers);
+    size_t bridgeCount = 0;
+    while (std::getline(in, item, ';')) {
+        trim(item);
+        double length = 0.0;
+        hikers.clear();
+        parseBridge(item, length, hikers);
+        handler.onBridge(length, hikers);
+        ++bridgeCount;
+    }
+    if (bridgeCount == 0) {
+        throw std::invalid_argument("Case format error: No bridge");
     }
 }
 
@@ -65,7 +106,7 @@ void CaseParser::parseHikers(const string& strHikers, vector<Hiker>& hikers) {
 
 // Bridge: length, additionalHiker1 speed1, ..., additionalHiker-n speed-n (hikers are optional)
 void CaseParser::parseBridge(const string& strBridge,
-    double& length, vector<Hiker>& additionalHikers) {
+    double& length, HikerPool& additionalHikers) {
     auto items = split(strBridge, ',');
     if (items.empty()) {
         throw std::invalid_argument("Bridge format error: No bridge length. " + strBridge);
@@ -74,6 +115,18 @@ void CaseParser::parseBridge(const string& strBridge,
     if (length <= 0) {
         throw std::out_of_range("Bridge's length should > 0");
     }
+    for (size_t i = 1; i < items.size(); ++i) {
+        additionalHikers.addHiker(parseHiker(items[i]));
+    }
+}
+
+void CaseParser::parseBridge(const string& strBridge,
+    double& length, vector<Hiker>& additionalHikers) {
+    auto items = split(strBridge, ',');
+    length = parse_double(items[0]);
+    if (length <= 0) {
+        throw std::out_of_range("Bridge's length should > 0");
+    }
     for (size_t i = 1; i < items.size(); ++i) {
         additionalHikers.emplace_back(parseHiker(items[i]));
     }
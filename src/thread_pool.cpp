@@ -0,0 +1,148 @@
+#include "thread_pool.h"
+
+#include <charconv>
+
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : threadCount_(threadCount), task_(nullptr), generation_(0), busyWorkers_(0),
+    stopping_(false) {
+    if (threadCount_ == 0) {
+        threadCount_ = std::thread::hardware_concurrency();
+    }
+    if (threadCount_ == 0) {
+        threadCount_ = 1;
+    }
+    ranges_.reset(new Range[threadCount_]);
+    for (size_t i = 0; i < threadCount_; ++i) {
+        ranges_[i].begin = ranges_[i].end = 0;
+    }
+    threads_.reserve(threadCount_ - 1);
+    for (size_t worker = 1; worker < threadCount_; ++worker) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count,
+    const std::function<void(size_t, size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    // Even split to start with, stealing evens out the rest.
+    for (size_t i = 0; i < threadCount_; ++i) {
+        std::lock_guard<std::mutex> lock(ranges_[i].mutex);
+        ranges_[i].begin = count * i / threadCount_;
+        ranges_[i].end = count * (i + 1) / threadCount_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        error_ = nullptr;
+        busyWorkers_ = threadCount_;
+        ++generation_;
+    }
+    wakeUp_.notify_all();
+    runTasks(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    allDone_.wait(lock, [this]() { return busyWorkers_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this, generation]() {
+                return stopping_ || generation_ != generation;
+            });
+            if (stopping_) {
+                return;
+            }
+            generation = generation_;
+        }
+        runTasks(worker);
+    }
+}
+
+void ThreadPool::runTasks(size_t worker) {
+    const std::function<void(size_t, size_t)>& task = *task_;
+    size_t index = 0;
+    while (popTask(worker, index) || (stealTasks(worker) && popTask(worker, index))) {
+        try {
+            task(index, worker);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busyWorkers_ == 0) {
+        allDone_.notify_one();
+    }
+}
+
+bool ThreadPool::popTask(size_t worker, size_t& index) {
+    Range& range = ranges_[worker];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin == range.end) {
+        return false;
+    }
+    index = range.begin++;
+    return true;
+}
+
+// Take the back half of the first non empty range after ours.
+bool ThreadPool::stealTasks(size_t worker) {
+    for (size_t i = 1; i < threadCount_; ++i) {
+        Range& victim = ranges_[(worker + i) % threadCount_];
+        size_t begin = 0;
+        size_t end = 0;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            size_t size = victim.end - victim.begin;
+            if (size == 0) {
+                continue;
+            }
+            end = victim.end;
+            victim.end -= (size + 1) / 2;
+            begin = victim.end;
+        }
+        Range& range = ranges_[worker];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        range.begin = begin;
+        range.end = end;
+        return true;
+    }
+    return false;
+}
+
+bool parse_thread_count(const std::string& str, size_t& threadCount)
+{
+    size_t value = 0;
+    const char* end = str.data() + str.size();
+    auto result = std::from_chars(str.data(), end, value);
+    if (result.ec != std::errc() || result.ptr != end || value > kMaxThreadCount) {
+        return false;
+    }
+    threadCount = value;
+    return true;
+}
@@ -3,16 +3,39 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <utility>
 #include "hiker.h"
 #include "bridge.h"
+#include "speed_sort.h"
+#include "stats.h"
 
 
 using std::string;
 using std::vector;
 
-// Sort hikers by speed in descending order.
+// Sort hikers by speed in descending order. Many hikers are sorted by index
+// (see speed_sort.h) and each is then moved once to its place.
 void sort_hikers(vector<Hiker>& hikers)
 {
+    HIKER_STATS_TIMER(StatPhase::Sort);
+    if (hikers.size() >= kRadixSortMinCount) {
+        vector<double> speeds;
+        speeds.reserve(hikers.size());
+        for (auto& hiker : hikers) {
+            speeds.push_back(hiker.getSpeed());
+        }
+        vector<uint32_t> rows(hikers.size());
+        std::iota(rows.begin(), rows.end(), 0);
+        sort_rows_by_speed(speeds.data(), rows);
+        vector<Hiker> sorted;
+        sorted.reserve(hikers.size());
+        for (auto row : rows) {
+            sorted.push_back(std::move(hikers[row]));
+        }
+        hikers.swap(sorted);
+        return;
+    }
     std::sort(hikers.begin(), hikers.end(), [](const Hiker& lhs, const Hiker& rhs) {
         return lhs.getSpeed() > rhs.getSpeed();
     });
@@ -70,6 +93,12 @@ double parse_double(const string& str)
     return value;
 }
 
+bool ends_with(const string& str, const string& suffix)
+{
+    return str.size() >= suffix.size() &&
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 bool double_equal(double lhs, double rhs)
 {
     double epsilon = 1e-10; // std::numeric_limits<double>::epsilon();
@@ -0,0 +1,431 @@
+#include "yaml_event_parser.h"
+
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include <yaml-cpp/eventhandler.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "case_handler.h"
+#include "hiker_pool.h"
+#include "utils.h"
+#include "stats.h"
+
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// The value of a mapping key, kept until the mapping ends so that it is
+// checked when (and as) YAMLCaseParser checks it.
+struct RawValue {
+    enum class Kind { Missing, Null, Scalar, Collection };
+
+    Kind kind = Kind::Missing;
+    string value;
+    YAML::Mark mark;
+};
+
+struct RawHiker {
+    bool isMap = true;
+    RawValue item; // The item itself if it is not a map.
+    RawValue name;
+    RawValue speed;
+};
+
+// As looking `key` up in a node that is not a map: an error on a scalar, an
+// invalid node otherwise.
+[[noreturn]] void throw_not_a_map(const RawValue& node, const char* key)
+{
+    if (node.kind == RawValue::Kind::Scalar) {
+        throw YAML::BadSubscript(node.mark, string(key));
+    }
+    throw YAML::InvalidNode(key);
+}
+
+// As Node::as<string>() on the node: a null node reads "null".
+string to_string_value(const RawValue& raw, const char* key)
+{
+    switch (raw.kind) {
+    case RawValue::Kind::Missing:
+        throw YAML::InvalidNode(key);
+    case RawValue::Kind::Null:
+        return "null";
+    case RawValue::Kind::Collection:
+        throw YAML::TypedBadConversion<string>(raw.mark);
+    default:
+        return raw.value;
+    }
+}
+
+// As Node::as<double>() on the node. Plain decimal numbers are read with
+// from_chars, anything else goes through yaml-cpp's own conversion.
+double to_double_value(const RawValue& raw, const char* key)
+{
+    if (raw.kind == RawValue::Kind::Missing) {
+        throw YAML::InvalidNode(key);
+    }
+    if (raw.kind != RawValue::Kind::Scalar) {
+        throw YAML::TypedBadConversion<double>(raw.mark);
+    }
+    const char* begin = raw.value.data();
+    const char* end = begin + raw.value.size();
+    double value = 0.0;
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec == std::errc() && result.ptr == end && std::isfinite(value)) {
+        return value;
+    }
+    try {
+        return YAML::Node(raw.value).as<double>();
+    }
+    catch (const YAML::BadConversion&) {
+        throw YAML::TypedBadConversion<double>(raw.mark);
+    }
+}
+
+Hiker to_hiker(const RawHiker& raw)
+{
+    if (!raw.isMap) {
+        throw_not_a_map(raw.item, "name");
+    }
+    string name = to_string_value(raw.name, "name");
+    double speed = to_double_value(raw.speed, "speed");
+    if (speed > 0) {
+        return Hiker(name, speed);
+    }
+    throw std::out_of_range("Speed should > 0");
+}
+
+void to_hikers(const vector<RawHiker>& rawHikers, vector<Hiker>& hikers, std::ostream& log)
+{
+    for (auto& rawHiker : rawHikers) {
+        try {
+            hikers.emplace_back(to_hiker(rawHiker));
+        }
+        catch (const std::exception& e) {
+            log << "Parse hiker error: " << e.what() << std::endl;
+            throw;
+        }
+    }
+}
+
+// Follows the events with a stack of the collections they are in, and
+// hands the case to a CaseHandler.
+class CaseEventHandler : public YAML::EventHandler {
+public:
+    CaseEventHandler(CaseHandler& handler, std::ostream& log)
+        : handler_(handler), log_(log), hikersSeen_(false), origHikersDone_(false),
+        bridgesSeen_(false), bridgeHikersSeen_(false) {
+    }
+
+    void OnDocumentStart(const YAML::Mark&) override {}
+    void OnDocumentEnd() override {}
+
+    void OnNull(const YAML::Mark& mark, YAML::anchor_t anchor) override {
+        RawValue raw;
+        raw.kind = RawValue::Kind::Null;
+        raw.mark = mark;
+        onValue(raw, anchor);
+    }
+    void OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) override {
+        auto it = anchors_.find(anchor);
+        if (it == anchors_.end()) {
+            throw YAML::ParserException(mark, "aliases of collections are not supported");
+        }
+        RawValue raw = it->second;
+        onValue(raw, 0);
+    }
+    void OnScalar(const YAML::Mark& mark, const string&, YAML::anchor_t anchor,
+        const string& value) override {
+        RawValue raw;
+        raw.kind = RawValue::Kind::Scalar;
+        raw.value = value;
+        raw.mark = mark;
+        onValue(raw, anchor);
+    }
+    void OnSequenceStart(const YAML::Mark& mark, const string&, YAML::anchor_t,
+        YAML::EmitterStyle::value) override {
+        onCollectionStart(false, mark);
+    }
+    void OnSequenceEnd() override { onCollectionEnd(); }
+    void OnMapStart(const YAML::Mark& mark, const string&, YAML::anchor_t,
+        YAML::EmitterStyle::value) override {
+        onCollectionStart(true, mark);
+    }
+    void OnMapEnd() override { onCollectionEnd(); }
+
+    // A document without hikers has no original hikers.
+    void finish() {
+        if (!origHikersDone_) {
+            finishOriginalHikers();
+        }
+    }
+
+private:
+    enum class Frame { TopMap, HikerSeq, HikerMap, BridgeSeq, BridgeMap, Ignored };
+
+    struct Context {
+        Frame frame;
+        bool expectKey;
+        string key;
+        vector<RawHiker>* hikers; // Where HikerSeq and HikerMap put hikers.
+    };
+
+    struct PendingBridge {
+        double length;
+        vector<Hiker> newHikers;
+    };
+
+    void push(Frame frame, vector<RawHiker>* hikers = nullptr) {
+        stack_.push_back(Context{frame, true, string(), hikers});
+    }
+
+    static bool isMapFrame(Frame frame) {
+        return frame == Frame::TopMap || frame == Frame::HikerMap || frame == Frame::BridgeMap;
+    }
+
+    void onValue(const RawValue& raw, YAML::anchor_t anchor) {
+        if (anchor) {
+            anchors_[anchor] = raw;
+        }
+        if (stack_.empty()) {
+            // A document that is only a scalar.
+            if (raw.kind == RawValue::Kind::Scalar) {
+                throw_not_a_map(raw, "hikers");
+            }
+            return;
+        }
+        Context& context = stack_.back();
+        if (isMapFrame(context.frame)) {
+            if (context.expectKey) {
+                context.key = raw.value;
+                context.expectKey = false;
+                return;
+            }
+            context.expectKey = true;
+            isFirstKey(context);
+            setMapValue(context, raw);
+        }
+        else if (context.frame == Frame::HikerSeq) {
+            context.hikers->push_back(RawHiker());
+            context.hikers->back().isMap = false;
+            context.hikers->back().item = raw;
+        }
+        else if (context.frame == Frame::BridgeSeq) {
+            throw_not_a_map(raw, "length");
+        }
+    }
+
+    void setMapValue(Context& context, const RawValue& raw) {
+        RawValue* value = nullptr;
+        if (context.frame == Frame::HikerMap) {
+            RawHiker& hiker = context.hikers->back();
+            value = context.key == "name" ? &hiker.name
+                : context.key == "speed" ? &hiker.speed : nullptr;
+        }
+        else if (context.frame == Frame::BridgeMap && context.key == "length") {
+            value = &bridgeLength_;
+        }
+        // The first of duplicate keys is the one looked up.
+        if (value && value->kind == RawValue::Kind::Missing) {
+            *value = raw;
+        }
+    }
+
+    void onCollectionStart(bool isMap, const YAML::Mark& mark) {
+        if (stack_.empty()) {
+            push(isMap ? Frame::TopMap : Frame::Ignored);
+            return;
+        }
+        Context& context = stack_.back();
+        if (context.frame == Frame::Ignored) {
+            push(Frame::Ignored);
+        }
+        else if (isMapFrame(context.frame)) {
+            if (context.expectKey) {
+                context.key.clear();
+                context.expectKey = false;
+                push(Frame::Ignored);
+                return;
+            }
+            context.expectKey = true;
+            onCollectionValue(context, isMap, mark);
+        }
+        else if (context.frame == Frame::HikerSeq) {
+            vector<RawHiker>* hikers = context.hikers;
+            hikers->push_back(RawHiker());
+            hikers->back().isMap = isMap;
+            hikers->back().item.kind = RawValue::Kind::Collection;
+            push(isMap ? Frame::HikerMap : Frame::Ignored, hikers);
+        }
+        else if (context.frame == Frame::BridgeSeq) {
+            if (!isMap) {
+                throw_not_a_map(RawValue(), "length");
+            }
+            bridgeLength_ = RawValue();
+            bridgeHikers_.clear();
+            bridgeHikersSeen_ = false;
+            push(Frame::BridgeMap);
+        }
+    }
+
+    // Whether this is the first hikers or bridges key of its map; any later
+    // one is skipped, whatever the kind of the first one's value.
+    bool isFirstKey(const Context& context) {
+        bool* seen = nullptr;
+        if (context.frame == Frame::TopMap) {
+            seen = context.key == "hikers" ? &hikersSeen_
+                : context.key == "bridges" ? &bridgesSeen_ : nullptr;
+        }
+        else if (context.frame == Frame::BridgeMap && context.key == "hikers") {
+            seen = &bridgeHikersSeen_;
+        }
+        if (!seen || *seen) {
+            return false;
+        }
+        *seen = true;
+        return true;
+    }
+
+    void onCollectionValue(Context& context, bool isMap, const YAML::Mark& mark) {
+        if (isFirstKey(context) && !isMap) {
+            if (context.frame == Frame::BridgeMap) {
+                push(Frame::HikerSeq, &bridgeHikers_);
+            }
+            else if (context.key == "hikers") {
+                push(Frame::HikerSeq, &origHikers_);
+            }
+            else {
+                push(Frame::BridgeSeq);
+            }
+            return;
+        }
+        RawValue raw;
+        raw.kind = RawValue::Kind::Collection;
+        raw.mark = mark;
+        setMapValue(context, raw);
+        push(Frame::Ignored);
+    }
+
+    void onCollectionEnd() {
+        Context context = stack_.back();
+        stack_.pop_back();
+        if (context.frame == Frame::HikerSeq && context.hikers == &origHikers_) {
+            finishOriginalHikers();
+        }
+        else if (context.frame == Frame::BridgeMap) {
+            finishBridge();
+        }
+    }
+
+    void finishOriginalHikers() {
+        vector<Hiker> hikers;
+        to_hikers(origHikers_, hikers, log_);
+        origHikers_.clear();
+        sort_hikers(hikers);
+        handler_.onOriginalHikers(hikers);
+        origHikersDone_ = true;
+        for (auto& bridge : pendingBridges_) {
+            handler_.onBridge(bridge.length, bridge.newHikers);
+        }
+        pendingBridges_.clear();
+    }
+
+    void finishBridge() {
+        double length = to_double_value(bridgeLength_, "length");
+        if (length <= 0) {
+            throw std::out_of_range("Bridge's length should > 0");
+        }
+        newHikers_.clear();
+        to_hikers(bridgeHikers_, newHikers_, log_);
+        if (origHikersDone_) {
+            handler_.onBridge(length, newHikers_);
+        }
+        else {
+            pendingBridges_.push_back(PendingBridge{length, newHikers_});
+        }
+    }
+
+    CaseHandler& handler_;
+    std::ostream& log_;
+    vector<Context> stack_;
+    std::map<YAML::anchor_t, RawValue> anchors_;
+    vector<RawHiker> origHikers_;
+    bool hikersSeen_;
+    bool origHikersDone_;
+    bool bridgesSeen_;
+    RawValue bridgeLength_;
+    vector<RawHiker> bridgeHikers_;
+    bool bridgeHikersSeen_;
+    vector<Hiker> newHikers_;
+    vector<PendingBridge> pendingBridges_;
+};
+
+// Builds the bridges on a shared pool, as YAMLCaseParser does.
+class CaseCollector : public CaseHandler {
+public:
+    CaseCollector(vector<Hiker>& origHikers, vector<Bridge>& bridges)
+        : origHikers_(origHikers), bridges_(bridges),
+        additionalHikers_(std::make_shared<HikerPool>()) {
+    }
+
+    void onOriginalHikers(const vector<Hiker>& origHikers) override {
+        origHikers_.insert(origHikers_.end(), origHikers.begin(), origHikers.end());
+    }
+    void onBridge(double length, const vector<Hiker>& newHikers) override {
+        size_t size = additionalHikers_->size();
+        for (auto& hiker : newHikers) {
+            additionalHikers_->addHiker(hiker);
+        }
+        bridges_.emplace_back(Bridge(length, additionalHikers_, size, additionalHikers_->size()));
+    }
+    void finish() { additionalHikers_->sortBySpeed(); }
+
+private:
+    vector<Hiker>& origHikers_;
+    vector<Bridge>& bridges_;
+    std::shared_ptr<HikerPool> additionalHikers_;
+};
+
+} // namespace
+
+void YAMLEventCaseParser::parse(std::istream& in,
+    vector<Hiker>& origHikers, vector<Bridge>& bridges) {
+    HIKER_STATS_TIMER(StatPhase::Parse);
+    CaseCollector collector(origHikers, bridges);
+    parse(in, collector);
+    collector.finish();
+}
+
+void YAMLEventCaseParser::parse(std::istream& in, CaseHandler& handler) {
+    CaseEventHandler eventHandler(handler, log_);
+    YAML::Parser parser(in);
+    parser.HandleNextDocument(eventHandler);
+    eventHandler.finish();
+}
+
+void YAMLEventCaseParser::parseFile(const string& filename,
+    vector<Hiker>& origHikers, vector<Bridge>& bridges) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw YAML::BadFile(filename);
+    }
+    parse(in, origHikers, bridges);
+}
+
+void YAMLEventCaseParser::parseFile(const string& filename, CaseHandler& handler) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw YAML::BadFile(filename);
+    }
+    parse(in, handler);
+}
@@ -1,10 +1,13 @@
 #include "yaml_parser.h"
 
+#include <memory>
 #include <iostream>
 #include <yaml-cpp/yaml.h>
 
 #include "hiker.h"
 #include "bridge.h"
+#include "case_handler.h"
+#include "hiker_pool.h"
 #include "utils.h"
 
 
@@ -15,16 +18,27 @@ void YAMLCaseParser::parse(const YAML::Node& node,
     vector<Hiker>& origHikers, vector<Bridge>& bridges) {
     parseHikers(node["hikers"], origHikers);
     sort_hikers(origHikers);
-    vector<Hiker> additionalHikers;
+    // All bridges share the pool of additional hikers.
+    auto additionalHikers = std::make_shared<HikerPool>();
     for (auto& bridge : node["bridges"]) {
         double length = 0.0;
-        size_t size = additionalHikers.size();
-        parseBridge(bridge, length, additionalHikers);
-        // New additional hiker(s) are added, need sort.
-        if (additionalHikers.size() > size) {
-            sort_hikers(additionalHikers);
-        }
-        bridges.emplace_back(Bridge(length, additionalHikers));
+        size_t size = additionalHikers->size();
+        parseBridge(bridge, length, *additionalHikers);
+        bridges.emplace_back(Bridge(length, additionalHikers, size, additionalHikers->size()));
+    }
+    additionalHikers->sortBySpeed();
+}
+
+void YAMLCaseParser::parse(const YAML::Node& node, CaseHandler& handler) {
+    vector<Hiker> hikers;
+    parseHikers(node["hikers"], hikers);
+    sort_hikers(hikers);
+    handler.onOriginalHikers(hikers);
+    for (auto& bridge : node["bridges"]) {
+        double length = 0.0;
+        hikers.clear();
+        parseBridge(bridge, length, hikers);
+        handler.onBridge(length, hikers);
     }
 }
 
@@ -49,6 +63,23 @@ void YAMLCaseParser::parseHikers(const YAML::Node& node, vector<Hiker>& hikers)
     }
 }
 
+void YAMLCaseParser::parseBridge(const YAML::Node& node,
+    double& length, HikerPool& additionalHikers) {
+    length = node["length"].as<double>();
+    if (length <= 0) {
+        throw std::out_of_range("Bridge's length should > 0");
+    }
+    for (auto& hiker : node["hikers"]) {
+        try {
+            additionalHikers.addHiker(parseHiker(hiker));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Parse hiker error: " << e.what() << std::endl;
+            throw;
+        }
+    }
+}
+
 void YAMLCaseParser::parseBridge(const YAML::Node& node,
     double& length, vector<Hiker>& additionalHikers) {
     length = node["length"].as<double>();
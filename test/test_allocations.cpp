@@ -0,0 +1,179 @@
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "cache.h"
+#include "calculator.h"
+#include "fast_case_parser.h"
+
+// Global operator new replaced for the whole test binary: it counts the
+// allocations of the thread that asked for counting, and otherwise behaves
+// like the default one. GCC sees the inlined free() of the replaced delete
+// after operator new and takes it for a mismatch.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+namespace {
+
+thread_local bool counting = false;
+thread_local size_t allocationCount = 0;
+
+void* counted_malloc(size_t size)
+{
+    if (counting) {
+        ++allocationCount;
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    void* pointer = counted_malloc(size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace {
+
+// Allocations made by solve() on this thread.
+template <typename Solve>
+size_t count_allocations(Solve solve)
+{
+    allocationCount = 0;
+    counting = true;
+    solve();
+    counting = false;
+    return allocationCount;
+}
+
+// A big first bridge (the radix sort of the profile and dp engines), then
+// a few hikers at some bridges and none at others.
+std::string make_case(uint64_t seed, size_t firstBridgeHikers)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> speed(1, 400);
+    std::ostringstream oss;
+    for (int i = 0; i < 8; ++i) {
+        oss << (i ? "," : "") << "O" << i << " " << speed(rng) * 0.25;
+    }
+    for (int bridge = 0; bridge < 40; ++bridge) {
+        oss << ";" << 10 + bridge;
+        size_t count = bridge == 0 ? firstBridgeHikers : bridge % 3 == 0 ? bridge % 5 : 0;
+        for (size_t i = 0; i < count; ++i) {
+            oss << ",X" << bridge << "_" << i << " " << speed(rng) * 0.25;
+        }
+    }
+    return oss.str();
+}
+
+struct ParsedCase {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+};
+
+ParsedCase parse(const std::string& strCase)
+{
+    ParsedCase parsed;
+    CaseParseError error;
+    EXPECT_TRUE(FastCaseParser().parse(strCase, parsed.origHikers, parsed.bridges, error));
+    return parsed;
+}
+
+} // namespace
+
+TEST(AllocationTest, CountsAllocations) {
+    EXPECT_EQ(count_allocations([] {
+        std::vector<int> values(10);
+        // Keep the compiler from eliding the allocation.
+        asm volatile("" : : "g"(values.data()) : "memory");
+    }), 1u);
+}
+
+// Once a case has been solved, solving it again or a smaller one does not
+// touch the heap, whatever the engine.
+TEST(AllocationTest, SteadyStateSolveDoesNotAllocate) {
+    ParsedCase big = parse(make_case(1, 300));
+    ParsedCase small = parse(make_case(2, 20));
+    typedef CrossingTimeCalculator::Engine Engine;
+    for (auto engine : {Engine::Greedy, Engine::Incremental, Engine::Profile, Engine::DP}) {
+        CrossingTimeCalculator calc(nullptr);
+        calc.setEngine(engine);
+        double bigTime = calc.calcCrossingTime(big.bridges, big.origHikers, false);
+        CrossingTimeCalculator fresh(nullptr);
+        fresh.setEngine(engine);
+        double smallTime = fresh.calcCrossingTime(small.bridges, small.origHikers, false);
+        double time = 0.0;
+        EXPECT_EQ(count_allocations([&] {
+            time = calc.calcCrossingTime(big.bridges, big.origHikers, false);
+        }), 0u) << static_cast<int>(engine);
+        EXPECT_EQ(time, bigTime);
+        EXPECT_EQ(count_allocations([&] {
+            time = calc.calcCrossingTime(small.bridges, small.origHikers, false);
+        }), 0u) << static_cast<int>(engine);
+        EXPECT_EQ(time, smallTime);
+    }
+}
+
+TEST(AllocationTest, CachedSolveDoesNotAllocate) {
+    ParsedCase first = parse(make_case(3, 50));
+    ParsedCase second = parse(make_case(4, 50));
+    double expected = CrossingTimeCalculator(nullptr).calcCrossingTime(
+        second.bridges, second.origHikers, false);
+    Cache cache(1 << 20);
+    CrossingTimeCalculator calc(&cache);
+    calc.calcCrossingTime(first.bridges, first.origHikers, false);
+    // Groups the cache has not seen: misses and insertions, then hits.
+    double time = 0.0;
+    for (int pass = 0; pass < 2; ++pass) {
+        EXPECT_EQ(count_allocations([&] {
+            time = calc.calcCrossingTime(second.bridges, second.origHikers, false);
+        }), 0u) << pass;
+        EXPECT_EQ(time, expected);
+    }
+    EXPECT_GT(cache.getStats().hits, 0u);
+}
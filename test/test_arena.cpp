@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "arena.h"
+#include "hiker_table.h"
+
+TEST(ArenaTest, AllocatesAlignedFromChunks) {
+    Arena arena;
+    EXPECT_EQ(arena.getCapacity(), 0u);
+    char* first = static_cast<char*>(arena.allocate(1, 1));
+    char* second = static_cast<char*>(arena.allocate(1, 1));
+    EXPECT_EQ(second, first + 1);
+    auto* aligned = arena.allocate(8, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0u);
+    EXPECT_EQ(arena.getCapacity(), Arena::kFirstChunkSize);
+
+    // Bigger than any chunk: gets its own.
+    arena.allocate(2 * Arena::kMaxChunkSize);
+    EXPECT_GE(arena.getCapacity(), 2 * Arena::kMaxChunkSize);
+    std::string_view copy = arena.copyString("hiker");
+    EXPECT_EQ(copy, "hiker");
+
+    arena.reset();
+    EXPECT_EQ(arena.getCapacity(), Arena::kFirstChunkSize);
+    EXPECT_EQ(arena.allocate(1, 1), first);
+}
+
+TEST(ArenaTest, NameTableCopiesAndMoves) {
+    NameTable names;
+    for (int i = 0; i < 1000; ++i) {
+        names.intern("hiker with a long name " + std::to_string(i % 500));
+    }
+    ASSERT_EQ(names.size(), 500u);
+    std::string_view name = names.getName(7);
+
+    NameTable copy(names);
+    EXPECT_EQ(copy.getName(7), name);
+    EXPECT_NE(copy.getName(7).data(), name.data());
+    EXPECT_EQ(copy.intern(name), 7u);
+
+    // Names stay where they are when the table moves.
+    NameTable moved(std::move(names));
+    EXPECT_EQ(moved.getName(7).data(), name.data());
+    moved = std::move(copy);
+    EXPECT_EQ(moved.intern("hiker with a long name 499"), 499u);
+    EXPECT_EQ(moved.intern("new"), 500u);
+}
@@ -0,0 +1,163 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "binary_case.h"
+#include "calculator.h"
+#include "string_parser.h"
+
+namespace {
+
+std::string temp_path(const char* name)
+{
+    return std::string("/tmp/hiker_") + name + "_" + std::to_string(getpid()) + ".bin";
+}
+
+// The message a case in memory is rejected with, or empty.
+std::string load_error(const std::string& bytes)
+{
+    std::vector<uint64_t> aligned((bytes.size() + 7) / 8);
+    memcpy(aligned.data(), bytes.data(), bytes.size());
+    try {
+        BinaryCase binaryCase(aligned.data(), bytes.size());
+    }
+    catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return std::string();
+}
+
+void set_double(std::string& bytes, size_t offset, double value)
+{
+    memcpy(&bytes[offset], &value, sizeof(value));
+}
+
+} // namespace
+
+TEST(BinaryCaseTest, RoundTrip) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15,E 2.5",
+        origHikers, bridges);
+    std::string path = temp_path("round_trip");
+    write_binary_case(path, origHikers, bridges);
+    {
+        BinaryCase binaryCase(path);
+        auto orig = binaryCase.getOriginalHikers();
+        ASSERT_EQ(orig.size, 4u);
+        EXPECT_EQ(orig.speeds[0], 100);
+        EXPECT_EQ(binaryCase.getName(orig.nameIds[3]), "D");
+        ASSERT_EQ(binaryCase.getBridgeCount(), 3u);
+        EXPECT_EQ(binaryCase.getAdditionalHikerCount(), 4u);
+        EXPECT_EQ(binaryCase.getBridge(1).length, 250);
+        EXPECT_EQ(binaryCase.getNewHikers(0).size, 0u);
+        auto newHikers = binaryCase.getNewHikers(2);
+        ASSERT_EQ(newHikers.size, 3u);
+        EXPECT_EQ(newHikers.speeds[1], 15);
+        EXPECT_EQ(newHikers.perFeetTimes[0], 1 / 25.0);
+        EXPECT_EQ(binaryCase.getName(newHikers.nameIds[2]), "E");
+        EXPECT_EQ(newHikers.nameIds[2], binaryCase.getNewHikers(1).nameIds[0]);
+
+        CrossingTimeCalculator calc(nullptr);
+        calc.setEngine(CrossingTimeCalculator::Engine::Greedy);
+        double expected = calc.calcCrossingTime(bridges, origHikers, false);
+        EXPECT_NEAR(calc.calcCrossingTime(binaryCase), expected, 1e-9);
+        calc.setEngine(CrossingTimeCalculator::Engine::Profile);
+        EXPECT_NEAR(calc.calcCrossingTime(binaryCase), expected, 1e-9);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(BinaryCaseTest, RejectsDamagedFiles) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50;100,C 20", origHikers, bridges);
+    std::string path = temp_path("damaged");
+    write_binary_case(path, origHikers, bridges);
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf();
+        bytes = oss.str();
+    }
+    // Truncated, then a bridge pointing past the hikers.
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size() - 1);
+    EXPECT_THROW(BinaryCase binaryCase(path), std::runtime_error);
+    std::string badBridge = bytes;
+    size_t bridgeOffset = sizeof(BinaryCaseHeader) + 3 * 2 * sizeof(double);
+    badBridge[bridgeOffset + 2 * sizeof(double)] = 9;
+    std::ofstream(path, std::ios::binary).write(badBridge.data(), badBridge.size());
+    EXPECT_THROW(BinaryCase binaryCase(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(BinaryCase binaryCase(path), std::runtime_error);
+}
+
+// Well-formed files with values the text parsers reject, or the engines
+// cannot cope with.
+TEST(BinaryCaseTest, RejectsInvalidValues) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50;100,C 20", origHikers, bridges);
+    std::string path = temp_path("values");
+    write_binary_case(path, origHikers, bridges);
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf();
+        bytes = oss.str();
+    }
+    EXPECT_EQ(load_error(bytes), "");
+    size_t speeds = sizeof(BinaryCaseHeader);
+    size_t perFeetTimes = speeds + 3 * sizeof(double);
+    size_t bridge = perFeetTimes + 3 * sizeof(double);
+
+    std::string negative = bytes;
+    set_double(negative, speeds + sizeof(double), -50);
+    set_double(negative, perFeetTimes + sizeof(double), 1 / -50.0);
+    EXPECT_EQ(load_error(negative), "Speed should > 0");
+    std::string additional = bytes;
+    set_double(additional, speeds + 2 * sizeof(double), 0);
+    EXPECT_EQ(load_error(additional), "Speed should > 0");
+    std::string notANumber = bytes;
+    set_double(notANumber, speeds, std::nan(""));
+    EXPECT_EQ(load_error(notANumber), "Speed should > 0");
+
+    std::string unsorted = bytes;
+    set_double(unsorted, speeds, 50);
+    set_double(unsorted, speeds + sizeof(double), 100);
+    set_double(unsorted, perFeetTimes, 1 / 50.0);
+    set_double(unsorted, perFeetTimes + sizeof(double), 1 / 100.0);
+    EXPECT_EQ(load_error(unsorted), "Original hikers should be sorted by speed");
+
+    std::string perFeetTime = bytes;
+    set_double(perFeetTime, perFeetTimes, 1 / 90.0);
+    EXPECT_EQ(load_error(perFeetTime), "Per feet time should be 1 / speed");
+
+    std::string length = bytes;
+    set_double(length, bridge, -100);
+    EXPECT_EQ(load_error(length), "Bridge's length should > 0");
+
+    // The file constructor gives the same reason.
+    std::ofstream(path, std::ios::binary).write(negative.data(), negative.size());
+    try {
+        BinaryCase binaryCase(path);
+        ADD_FAILURE() << "negative speed accepted";
+    }
+    catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string(e.what()), "Speed should > 0: " + path);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,169 @@
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "cache.h"
+#include "persistent_cache.h"
+
+namespace {
+
+GroupKey make_key(std::vector<double> origSpeeds, std::vector<double> additionalSpeeds)
+{
+    GroupFingerprint fingerprint;
+    for (double speed : origSpeeds) {
+        fingerprint.addOriginalHiker(speed);
+    }
+    for (double speed : additionalSpeeds) {
+        fingerprint.addAdditionalHiker(speed);
+    }
+    return fingerprint.getKey();
+}
+
+size_t resident_bytes()
+{
+    size_t pages = 0;
+    size_t residentPages = 0;
+    std::ifstream("/proc/self/statm") >> pages >> residentPages;
+    return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+TEST(GroupFingerprintTest, KeyIsTheSpeedMultiset) {
+    EXPECT_TRUE(make_key({100, 50, 20}, {10}) == make_key({20, 100, 50}, {10}));
+    EXPECT_FALSE(make_key({100, 50}, {20}) == make_key({100, 20}, {50}));
+    EXPECT_FALSE(make_key({100, 50}, {}) == make_key({100, 50, 50}, {}));
+
+    GroupFingerprint fingerprint;
+    fingerprint.addOriginalHiker(100);
+    fingerprint.addAdditionalHiker(5);
+    fingerprint.removeAdditionalHiker(5);
+    EXPECT_TRUE(fingerprint.getKey() == make_key({100}, {}));
+}
+
+TEST(CacheTest, HitsAndMisses) {
+    Cache cache;
+    GroupKey key = make_key({100, 50}, {20});
+    EXPECT_EQ(cache.getTime(key), -1.0);
+    cache.setTime(key, 0.17);
+    EXPECT_EQ(cache.getTime(key), 0.17);
+    EXPECT_EQ(cache.getTime(make_key({100, 50}, {})), -1.0);
+
+    CacheStats stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.insertions, 1u);
+    EXPECT_EQ(stats.evictions, 0u);
+
+    cache.reset();
+    EXPECT_EQ(cache.getTime(key), -1.0);
+}
+
+// One shard of kWays slots: every key competes for the same slots.
+TEST(CacheTest, EvictsUnreferencedFirst) {
+    Cache cache(0, 1);
+    ASSERT_EQ(cache.getCapacity(), Cache::kWays);
+    std::vector<GroupKey> keys;
+    for (size_t i = 0; i <= Cache::kWays; ++i) {
+        keys.push_back(make_key({100.0 + i}, {}));
+    }
+    for (size_t i = 0; i < Cache::kWays; ++i) {
+        cache.setTime(keys[i], 1.0 + i);
+    }
+    for (size_t i = 1; i < Cache::kWays; ++i) {
+        EXPECT_EQ(cache.getTime(keys[i]), 1.0 + i);
+    }
+    cache.setTime(keys[Cache::kWays], 42.0);
+    EXPECT_EQ(cache.getStats().evictions, 1u);
+    EXPECT_EQ(cache.getTime(keys[0]), -1.0);
+    EXPECT_EQ(cache.getTime(keys[Cache::kWays]), 42.0);
+    for (size_t i = 1; i < Cache::kWays; ++i) {
+        EXPECT_EQ(cache.getTime(keys[i]), 1.0 + i);
+    }
+}
+
+// The default 64 MiB table only takes memory for the slots in use, also
+// after a reset.
+TEST(CacheTest, TableTakesMemoryAsUsed) {
+    size_t before = resident_bytes();
+    Cache cache;
+    for (int i = 0; i < 100; ++i) {
+        cache.setTime(make_key({1.0 + i}, {}), 1.0 + i);
+    }
+    EXPECT_LT(resident_bytes(), before + (4 << 20));
+    cache.reset();
+    EXPECT_EQ(cache.getTime(make_key({1.0}, {})), -1.0);
+    EXPECT_LT(resident_bytes(), before + (4 << 20));
+}
+
+TEST(CacheTest, SharedByThreads) {
+    Cache cache(1 << 20, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache]() {
+            for (int i = 0; i < 1000; ++i) {
+                GroupKey key = make_key({1.0 + i}, {});
+                if (cache.getTime(key) < 0) {
+                    cache.setTime(key, 1.0 + i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CacheStats stats = cache.getStats();
+    EXPECT_EQ(stats.hits + stats.misses, 4000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(cache.getTime(make_key({1.0 + i}, {})), 1.0 + i);
+    }
+}
+
+TEST(PersistentCacheTest, SurvivesReopen) {
+    std::string path = "/tmp/hiker_cache_test_" + std::to_string(getpid());
+    std::remove(path.c_str());
+    GroupKey key = make_key({100, 50}, {20, 10});
+    {
+        PersistentCache persistentCache(path, 1000);
+        EXPECT_EQ(persistentCache.getSlotCount(), 1024u);
+        EXPECT_EQ(persistentCache.getTime(key), -1.0);
+        EXPECT_TRUE(persistentCache.setTime(key, 0.17));
+    }
+    {
+        // The existing file keeps its size.
+        PersistentCache persistentCache(path, 8);
+        EXPECT_EQ(persistentCache.getSlotCount(), 1024u);
+        EXPECT_EQ(persistentCache.getTime(key), 0.17);
+
+        // Memory misses fall through to the file.
+        Cache cache(0, 1);
+        cache.setPersistentCache(&persistentCache);
+        EXPECT_EQ(cache.getTime(key), 0.17);
+        EXPECT_EQ(cache.getTime(key), 0.17);
+        GroupKey other = make_key({100}, {});
+        EXPECT_EQ(cache.getTime(other), -1.0);
+        cache.setTime(other, 0.01);
+        EXPECT_EQ(persistentCache.getTime(other), 0.01);
+        CacheStats stats = cache.getStats();
+        EXPECT_EQ(stats.persistentHits, 1u);
+        EXPECT_EQ(stats.hits, 1u);
+        EXPECT_EQ(stats.misses, 1u);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(PersistentCacheTest, RejectsOtherFiles) {
+    std::string path = "/tmp/hiker_cache_test_bad_" + std::to_string(getpid());
+    FILE* file = fopen(path.c_str(), "w");
+    ASSERT_TRUE(file);
+    fputs("A 100,B 50;100\n", file);
+    fclose(file);
+    EXPECT_THROW(PersistentCache persistentCache(path), std::runtime_error);
+    std::remove(path.c_str());
+}
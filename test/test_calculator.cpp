@@ -0,0 +1,367 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "cache.h"
+#include "calculator.h"
+#include "crossing_plan.h"
+#include "dp_engine.h"
+#include "group_engine.h"
+#include "plan_writer.h"
+#include "hiker_group.h"
+#include "small_group.h"
+#include "streaming_solver.h"
+#include "string_parser.h"
+#include "thread_pool.h"
+
+namespace {
+
+double calc(const std::string& strCase, CrossingTimeCalculator::Engine engine)
+{
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse(strCase, origHikers, bridges);
+    CrossingTimeCalculator calc(nullptr);
+    calc.setEngine(engine);
+    return calc.calcCrossingTime(bridges, origHikers, false);
+}
+
+// Random case in the string format, speeds drawn from a few scales so that
+// hikers end up on both sides of the threshold speed, with repeated speeds.
+std::string random_case(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> hikerCount(1, 8);
+    std::uniform_int_distribution<int> bridgeCount(1, 6);
+    std::uniform_int_distribution<int> newHikerCount(0, 3);
+    std::uniform_int_distribution<int> speed(1, 40);
+    std::ostringstream oss;
+    int origCount = hikerCount(rng);
+    for (int i = 0; i < origCount; ++i) {
+        oss << (i ? "," : "") << "H" << i << " " << speed(rng) * 2.5;
+    }
+    int bridges = bridgeCount(rng);
+    for (int i = 0; i < bridges; ++i) {
+        oss << ";" << speed(rng) * 10;
+        int count = newHikerCount(rng);
+        for (int j = 0; j < count; ++j) {
+            oss << ",X" << i << "_" << j << " " << speed(rng) * 2.5;
+        }
+    }
+    return oss.str();
+}
+
+} // namespace
+
+TEST(CalculatorTest, KnownCases) {
+    struct { double time; const char* strCase; } cases[] = {
+        {245, "A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15"},
+        {1, "A 100;100"},
+        {2, "A 100,B 50;100"},
+        {17, "A 100,B 50,C 20,D 10;100"},
+        {21, "A 100,B 25,C 20,D 10;100"},
+        {55.5, "A 100,B 50,C 20,D 10;100;200,E 80"},
+        {63, "A 100;100,B 50,C 20,D 10;200,E 50"},
+    };
+    for (auto& testCase : cases) {
+        EXPECT_NEAR(calc(testCase.strCase, CrossingTimeCalculator::Engine::Greedy),
+            testCase.time, 1e-9) << testCase.strCase;
+        EXPECT_NEAR(calc(testCase.strCase, CrossingTimeCalculator::Engine::Incremental),
+            testCase.time, 1e-9) << testCase.strCase;
+        EXPECT_NEAR(calc(testCase.strCase, CrossingTimeCalculator::Engine::Profile),
+            testCase.time, 1e-9) << testCase.strCase;
+        EXPECT_NEAR(calc(testCase.strCase, CrossingTimeCalculator::Engine::DP),
+            testCase.time, 1e-9) << testCase.strCase;
+    }
+}
+
+TEST(CalculatorTest, EnginesMatchGreedy) {
+    std::mt19937 rng(20240611);
+    for (int i = 0; i < 2000; ++i) {
+        std::string strCase = random_case(rng);
+        double expected = calc(strCase, CrossingTimeCalculator::Engine::Greedy);
+        EXPECT_NEAR(calc(strCase, CrossingTimeCalculator::Engine::Incremental),
+            expected, expected * 1e-12) << strCase;
+        EXPECT_NEAR(calc(strCase, CrossingTimeCalculator::Engine::Profile),
+            expected, expected * 1e-12) << strCase;
+        EXPECT_NEAR(calc(strCase, CrossingTimeCalculator::Engine::Auto),
+            expected, expected * 1e-12) << strCase;
+    }
+}
+
+TEST(CalculatorTest, AutoPicksEngineByShape) {
+    typedef CrossingTimeCalculator::Engine Engine;
+    EXPECT_EQ(CrossingTimeCalculator(nullptr).getEngine(), Engine::Auto);
+    // Many hikers over few bridges, as in the bench's many-hikers case.
+    EXPECT_EQ(CrossingTimeCalculator::chooseEngine(120000, 20), Engine::Greedy);
+    EXPECT_EQ(CrossingTimeCalculator::chooseEngine(7, 3), Engine::Greedy);
+    EXPECT_EQ(CrossingTimeCalculator::chooseEngine(9000, 2000), Engine::Incremental);
+    EXPECT_EQ(CrossingTimeCalculator::chooseEngine(20008, 20000), Engine::Incremental);
+}
+
+TEST(CalculatorTest, DPNeverWorseThanGreedy) {
+    std::mt19937 rng(20241017);
+    std::uniform_int_distribution<int> count(1, 12);
+    std::uniform_int_distribution<int> speed(1, 40);
+    const GroupEngine* greedy = find_group_engine("greedy");
+    ASSERT_NE(greedy, nullptr);
+    for (int round = 0; round < 5000; ++round) {
+        // Original hikers, then additional hikers (maybe none).
+        HikerColumns columns[2];
+        for (int side = 0; side < 2; ++side) {
+            int hikerCount = count(rng) - side;
+            for (int i = 0; i < hikerCount; ++i) {
+                double value = speed(rng) * 2.5;
+                columns[side].addHiker(value, 1 / value, 0);
+            }
+            columns[side].sortBySpeed();
+        }
+        HikerSpan hikers = columns[0].getSpan();
+        HikerSpan additionalHikers = columns[1].getSpan();
+        double expected = greedy->calcPerFeetTime(hikers, additionalHikers);
+        double perFeetTime = calc_dp_per_feet_time(hikers, additionalHikers);
+        if (additionalHikers.size == 0 || additionalHikers.speeds[0] <= hikers.speeds[0]) {
+            EXPECT_NEAR(perFeetTime, expected, expected * 1e-12);
+        }
+        else {
+            EXPECT_LE(perFeetTime, expected * (1 + 1e-12));
+        }
+    }
+    // Two additional hikers faster than A and B: crossing together (A and B
+    // cross, A returns, the two cross, B returns) beats A helping each.
+    HikerTable table;
+    table.addHiker("A", 20);
+    table.addHiker("B", 20);
+    table.addHiker("E", 50);
+    table.addHiker("F", 50);
+    EXPECT_NEAR(greedy->calcPerFeetTime(table.getSpan(0, 2), table.getSpan(2, 4)), 0.25, 1e-12);
+    EXPECT_NEAR(calc_dp_per_feet_time(table.getSpan(0, 2), table.getSpan(2, 4)), 0.22, 1e-12);
+}
+
+// E and F are faster than A and B, so the dp engine finds 22 where the
+// greedy plan takes 25; a shared cache must not hand one to the other.
+TEST(CalculatorTest, DPResultsCachedApart) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 20,B 20;100,E 50,F 50", origHikers, bridges);
+    Cache cache;
+    CrossingTimeCalculator calc(&cache);
+    calc.setEngine(CrossingTimeCalculator::Engine::DP);
+    EXPECT_NEAR(calc.calcCrossingTime(bridges, origHikers, false), 22, 1e-9);
+    calc.setEngine(CrossingTimeCalculator::Engine::Incremental);
+    EXPECT_NEAR(calc.calcCrossingTime(bridges, origHikers, false), 25, 1e-9);
+    calc.setEngine(CrossingTimeCalculator::Engine::DP);
+    EXPECT_NEAR(calc.calcCrossingTime(bridges, origHikers, false), 22, 1e-9);
+    EXPECT_GT(cache.getStats().hits, 0u);
+}
+
+TEST(HikerGroupTest, AddAndRemoveHikers) {
+    HikerGroup group;
+    EXPECT_DOUBLE_EQ(group.calcPerFeetTime(), -1.0);
+    group.addOriginalHiker(100);
+    group.addOriginalHiker(50);
+    group.addOriginalHiker(20);
+    group.addOriginalHiker(10);
+    EXPECT_NEAR(group.calcPerFeetTime(), 0.17, 1e-12);
+    group.addAdditionalHiker(80);
+    EXPECT_NEAR(group.calcPerFeetTime() * 200, 38.5, 1e-9);
+    EXPECT_FALSE(group.removeAdditionalHiker(20)); // C is an original hiker.
+    EXPECT_TRUE(group.removeAdditionalHiker(80));
+    EXPECT_NEAR(group.calcPerFeetTime(), 0.17, 1e-12);
+    EXPECT_TRUE(group.removeOriginalHiker(50));
+    EXPECT_FALSE(group.removeOriginalHiker(50));
+    // A helps C and D one by one.
+    EXPECT_NEAR(group.calcPerFeetTime(), 0.16, 1e-12);
+}
+
+TEST(HikerGroupTest, CachesPerFeetTime) {
+    HikerGroup group;
+    GroupFingerprint fingerprint;
+    for (double speed : {100.0, 50.0, 20.0, 10.0}) {
+        group.addOriginalHiker(speed);
+        fingerprint.addOriginalHiker(speed);
+    }
+    EXPECT_DOUBLE_EQ(group.calcPerFeetTime(nullptr, fingerprint.getKey()),
+        group.calcPerFeetTime());
+    Cache cache;
+    EXPECT_DOUBLE_EQ(group.calcPerFeetTime(&cache, fingerprint.getKey()),
+        group.calcPerFeetTime());
+    EXPECT_DOUBLE_EQ(cache.getTime(fingerprint.getKey()), group.calcPerFeetTime());
+    // A hit is returned as it is.
+    cache.setTime(fingerprint.getKey(), 42);
+    EXPECT_DOUBLE_EQ(group.calcPerFeetTime(&cache, fingerprint.getKey()), 42);
+    EXPECT_EQ(cache.getStats().misses, 1u);
+}
+
+TEST(HikerGroupTest, BuildsFromSortedSpeeds) {
+    const double origSpeeds[] = {100, 50, 20};
+    const double speeds[] = {100, 80, 50, 20, 20, 10, 2.5};
+    HikerGroup built;
+    built.build(origSpeeds, 3, speeds, 7);
+    HikerGroup inserted;
+    for (double speed : origSpeeds) {
+        inserted.addOriginalHiker(speed);
+    }
+    for (double speed : {80.0, 20.0, 10.0, 2.5}) {
+        inserted.addAdditionalHiker(speed);
+    }
+    EXPECT_EQ(built.getHikerCount(), 7u);
+    EXPECT_DOUBLE_EQ(built.calcPerFeetTime(), inserted.calcPerFeetTime());
+    built.addAdditionalHiker(30);
+    inserted.addAdditionalHiker(30);
+    EXPECT_TRUE(built.removeOriginalHiker(50));
+    EXPECT_TRUE(inserted.removeOriginalHiker(50));
+    EXPECT_DOUBLE_EQ(built.calcPerFeetTime(), inserted.calcPerFeetTime());
+}
+
+TEST(CalculatorTest, ParallelMatchesIncremental) {
+    std::mt19937 rng(20241016);
+    std::uniform_int_distribution<int> speed(1, 400);
+    std::uniform_int_distribution<int> newHikerCount(0, 2);
+    std::ostringstream oss;
+    oss << "A 100,B 50,C 20,D 10";
+    for (int i = 0; i < 3000; ++i) {
+        oss << ";" << speed(rng);
+        int count = newHikerCount(rng);
+        for (int j = 0; j < count; ++j) {
+            oss << ",X " << speed(rng) * 0.25;
+        }
+    }
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse(oss.str(), origHikers, bridges);
+    CrossingTimeCalculator calc(nullptr);
+    double expected = calc.calcCrossingTime(bridges, origHikers, false);
+
+    double totals[2];
+    size_t threadCounts[] = {1, 4};
+    for (int i = 0; i < 2; ++i) {
+        ThreadPool pool(threadCounts[i]);
+        calc.setThreadPool(&pool);
+        totals[i] = calc.calcCrossingTime(bridges, origHikers, false);
+        EXPECT_NEAR(totals[i], expected, expected * 1e-12);
+    }
+    // Same chunks, same sums, whatever the thread count.
+    EXPECT_EQ(totals[0], totals[1]);
+}
+
+TEST(HikerTableTest, InternsNamesAndSorts) {
+    HikerTable table;
+    table.addHiker("C", 20);
+    table.addHiker("A", 100);
+    table.addHiker("C", 10);
+    EXPECT_EQ(table.getNames().size(), 2u);
+    EXPECT_EQ(table.getNameId(0), table.getNameId(2));
+    table.sortBySpeed();
+    EXPECT_EQ(table.getName(0), "A");
+    EXPECT_DOUBLE_EQ(table.getSpeed(2), 10);
+    EXPECT_DOUBLE_EQ(table.getPerFeetTime(1), 1.0 / 20);
+}
+
+TEST(CalculatorTest, ColumnsMatchHikers) {
+    HikerTable table;
+    for (auto& hiker : {Hiker("A", 100), Hiker("B", 50), Hiker("C", 20), Hiker("D", 10)}) {
+        table.addHiker(hiker);
+    }
+    table.addHiker("E", 80);
+    table.addHiker("F", 2.5);
+    CrossingTimeCalculator calc(nullptr);
+    // A B C D are the original hikers, E F are additional (sorted).
+    // F and D cross together, then A helps E and C, then A and B cross.
+    EXPECT_NEAR(calc.calcPerFeetTime(table.getSpan(0, 4), table.getSpan(4, 6)),
+        (0.01 + 0.04 + 0.4) + (0.01 + 0.0125) + (0.01 + 0.05) + 0.02, 1e-12);
+    EXPECT_NEAR(calc.calcPerFeetTime(table.getSpan(0, 1), table.getSpan(1, 4)),
+        0.19, 1e-12);
+}
+
+TEST(CalculatorTest, SmallGroupKernelsMatchGeneralPlan) {
+    std::mt19937 rng(17);
+    // A few scales, so that groups have slow pairs, ties and additional
+    // hikers faster than the lead.
+    std::uniform_int_distribution<int> speed(1, 12);
+    CrossingTimeCalculator calc(nullptr);
+    for (size_t size = 2; size <= kMaxSmallGroupSize + 1; ++size) {
+        for (size_t origCount = 1; origCount <= size; ++origCount) {
+            for (int round = 0; round < 50; ++round) {
+                HikerColumns orig;
+                HikerColumns additional;
+                HikerGroup group;
+                for (size_t i = 0; i < size; ++i) {
+                    double s = speed(rng) * 7.5;
+                    (i < origCount ? orig : additional).addHiker(s, 1 / s, 0);
+                    if (i < origCount) {
+                        group.addOriginalHiker(s);
+                    }
+                    else {
+                        group.addAdditionalHiker(s);
+                    }
+                }
+                orig.sortBySpeed();
+                additional.sortBySpeed();
+                CrossingPlan plan;
+                plan.beginBridge(1, size);
+                double general = calc.calcPerFeetTime(orig.getSpan(), additional.getSpan(), &plan);
+                double expected = group.calcPerFeetTime();
+                EXPECT_NEAR(general, expected, 1e-12 * expected);
+                EXPECT_NEAR(calc.calcPerFeetTime(orig.getSpan(), additional.getSpan()),
+                    expected, 1e-12 * expected);
+                if (is_small_group(orig.size(), additional.size())) {
+                    EXPECT_NEAR(calc_small_group_per_feet_time(orig.getSpan(),
+                        additional.getSpan()), expected, 1e-12 * expected)
+                        << size << " hikers, " << origCount << " original";
+                }
+            }
+        }
+    }
+}
+
+TEST(PlanWriterTest, RendersRecordedPlan) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50,C 20,D 10;100;250,E 2.5", origHikers, bridges);
+    CrossingPlan plan;
+    CrossingTimeCalculator calc(nullptr);
+    calc.setPlan(&plan);
+    EXPECT_NEAR(calc.calcCrossingTime(bridges, origHikers, false), 17 + 0.53*250, 1e-9);
+    ASSERT_EQ(plan.getBridges().size(), 2u);
+
+    std::string text;
+    PlanWriter(PlanFormat::Text).write(plan, origHikers, bridges, text);
+    EXPECT_EQ(text, "Bridge (100)\n"
+        "A,B cross, A returns\nD,C cross, B returns\nA,B cross\n"
+        "Bridge (250)\n"
+        "A,B cross, A returns\nE,D cross, B returns\nA,C cross, A returns\nA,B cross\n");
+
+    std::string csv;
+    PlanWriter(PlanFormat::CSV).write(plan, origHikers, bridges, csv);
+    EXPECT_EQ(csv.substr(0, csv.find('\n', csv.find('\n') + 1)),
+        "bridge,length,step,first,second,returner\n0,100,0,A,B,A");
+}
+
+// Running totals match a full solve of the case cut after each bridge.
+TEST(StreamingSolverTest, MatchesFullSolve) {
+    std::mt19937 rng(7);
+    for (int i = 0; i < 300; ++i) {
+        std::string strCase = random_case(rng);
+        std::vector<double> totals;
+        StreamingSolver solver;
+        solver.setListener([&totals](size_t bridge, double, double totalTime) {
+            EXPECT_EQ(bridge, totals.size());
+            totals.push_back(totalTime);
+        });
+        std::istringstream in(strCase + "\n");
+        CaseParser().parse(in, solver);
+        ASSERT_EQ(totals.size(), solver.getBridgeCount());
+        size_t end = strCase.find(';');
+        for (size_t j = 0; j < totals.size(); ++j) {
+            end = strCase.find(';', end + 1);
+            double expected = calc(strCase.substr(0, end), CrossingTimeCalculator::Engine::Greedy);
+            EXPECT_NEAR(totals[j], expected, expected * 1e-12) << strCase;
+        }
+        EXPECT_EQ(solver.getTotalTime(), totals.back());
+    }
+}
@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bridge.h"
+#include "calculator.h"
+#include "case_analysis.h"
+#include "fast_case_parser.h"
+#include "hiker.h"
+
+namespace {
+
+// A case as lists of hikers, easy to change and write back.
+struct CaseHiker {
+    std::string name;
+    double speed;
+    size_t arrival;
+};
+
+struct EditableCase {
+    std::vector<double> lengths;
+    std::vector<CaseHiker> hikers;
+
+    std::string toString() const {
+        std::ostringstream oss;
+        oss.precision(17);
+        bool first = true;
+        for (auto& hiker : hikers) {
+            if (hiker.arrival == CaseAnalysis::kOriginal) {
+                oss << (first ? "" : ",") << hiker.name << " " << hiker.speed;
+                first = false;
+            }
+        }
+        for (size_t bridge = 0; bridge < lengths.size(); ++bridge) {
+            oss << ";" << lengths[bridge];
+            for (auto& hiker : hikers) {
+                if (hiker.arrival == bridge) {
+                    oss << "," << hiker.name << " " << hiker.speed;
+                }
+            }
+        }
+        return oss.str();
+    }
+};
+
+void parse(const std::string& strCase, std::vector<Hiker>& origHikers,
+    std::vector<Bridge>& bridges)
+{
+    CaseParseError error;
+    ASSERT_TRUE(FastCaseParser().parse(strCase, origHikers, bridges, error)) << strCase;
+}
+
+double solve(const EditableCase& editable)
+{
+    bool hasOriginal = false;
+    for (auto& hiker : editable.hikers) {
+        hasOriginal = hasOriginal || hiker.arrival == CaseAnalysis::kOriginal;
+    }
+    if (!hasOriginal) {
+        return -1.0; // Not a valid case.
+    }
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    parse(editable.toString(), origHikers, bridges);
+    return CrossingTimeCalculator(nullptr).calcCrossingTime(bridges, origHikers, false);
+}
+
+} // namespace
+
+TEST(CaseAnalysisTest, MarginalCostsOfGoldenCase) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    parse("A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15", origHikers, bridges);
+    CaseAnalysis analysis(bridges, origHikers);
+    EXPECT_DOUBLE_EQ(analysis.getTotalTime(), 245);
+    ASSERT_EQ(analysis.getHikerCount(), 7u);
+    size_t e = analysis.findHiker("E");
+    ASSERT_EQ(e, 4u);
+    EXPECT_EQ(analysis.getHiker(e).arrival, 1u);
+
+    std::vector<double> totals = analysis.evaluate({
+        CaseChange::removeHiker(e),
+        CaseChange::moveArrival(e, 2),
+        CaseChange::changeSpeed(e, 25),
+        CaseChange::addHiker(5, CaseAnalysis::kOriginal),
+    });
+    EXPECT_NEAR(totals[0], solve({{100, 250, 150}, {{"A", 100, CaseAnalysis::kOriginal},
+        {"B", 50, CaseAnalysis::kOriginal}, {"C", 20, CaseAnalysis::kOriginal},
+        {"D", 10, CaseAnalysis::kOriginal}, {"F", 25, 2}, {"G", 15, 2}}}), 1e-9);
+    EXPECT_NEAR(totals[0], 100, 1e-9);
+    EXPECT_LT(totals[1], 245);
+    EXPECT_LT(totals[2], 245);
+    EXPECT_GT(totals[3], 245);
+}
+
+TEST(CaseAnalysisTest, MatchesRecomputedCases) {
+    std::mt19937 rng(20241018);
+    std::uniform_int_distribution<int> speed(1, 40);
+    std::uniform_int_distribution<int> count(0, 3);
+    for (int round = 0; round < 100; ++round) {
+        EditableCase editable;
+        int origCount = 1 + count(rng);
+        for (int i = 0; i < origCount; ++i) {
+            editable.hikers.push_back({"O" + std::to_string(i), speed(rng) * 2.5,
+                CaseAnalysis::kOriginal});
+        }
+        int bridgeCount = 1 + count(rng) * 2;
+        for (int bridge = 0; bridge < bridgeCount; ++bridge) {
+            editable.lengths.push_back(speed(rng) * 10);
+            int newCount = count(rng) - 1;
+            for (int i = 0; i < newCount; ++i) {
+                editable.hikers.push_back({"X" + std::to_string(editable.hikers.size()),
+                    speed(rng) * 2.5, static_cast<size_t>(bridge)});
+            }
+        }
+        std::vector<Hiker> origHikers;
+        std::vector<Bridge> bridges;
+        parse(editable.toString(), origHikers, bridges);
+        CaseAnalysis analysis(bridges, origHikers);
+        EXPECT_NEAR(analysis.getTotalTime(), solve(editable), 1e-9);
+
+        // Every kind of change, recomputed from a changed case.
+        std::vector<CaseChange> changes;
+        std::vector<EditableCase> changed;
+        for (size_t hiker = 0; hiker < analysis.getHikerCount(); ++hiker) {
+            size_t index = 0;
+            for (; index < editable.hikers.size(); ++index) {
+                if (editable.hikers[index].name == analysis.getHiker(hiker).name) {
+                    break;
+                }
+            }
+            changes.push_back(CaseChange::removeHiker(hiker));
+            changed.push_back(editable);
+            changed.back().hikers.erase(changed.back().hikers.begin() + index);
+
+            double newSpeed = speed(rng) * 2.5;
+            changes.push_back(CaseChange::changeSpeed(hiker, newSpeed));
+            changed.push_back(editable);
+            changed.back().hikers[index].speed = newSpeed;
+
+            size_t bridge = rng() % (bridgeCount + 1);
+            bridge = bridge == static_cast<size_t>(bridgeCount) ? CaseAnalysis::kOriginal : bridge;
+            changes.push_back(CaseChange::moveArrival(hiker, bridge));
+            changed.push_back(editable);
+            changed.back().hikers[index].arrival = bridge;
+        }
+        size_t bridge = rng() % bridgeCount;
+        changes.push_back(CaseChange::addHiker(7.5, bridge));
+        changed.push_back(editable);
+        changed.back().hikers.push_back({"N", 7.5, bridge});
+
+        std::vector<double> totals = analysis.evaluate(changes);
+        ASSERT_EQ(totals.size(), changed.size());
+        for (size_t i = 0; i < totals.size(); ++i) {
+            double expected = solve(changed[i]);
+            EXPECT_NEAR(totals[i], expected, 1e-9 * (1 + expected)) << changed[i].toString();
+        }
+    }
+}
+
+TEST(CaseAnalysisTest, RejectsBadChanges) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    parse("A 100;100", origHikers, bridges);
+    CaseAnalysis analysis(bridges, origHikers);
+    EXPECT_THROW(analysis.evaluate({CaseChange::removeHiker(1)}), std::invalid_argument);
+    EXPECT_THROW(analysis.evaluate({CaseChange::addHiker(0, 0)}), std::invalid_argument);
+    EXPECT_THROW(analysis.evaluate({CaseChange::addHiker(10, 1)}), std::invalid_argument);
+    // No one left to carry the torch.
+    EXPECT_EQ(analysis.evaluate({CaseChange::removeHiker(0)})[0], -1.0);
+}
@@ -0,0 +1,182 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "binary_case.h"
+#include "cache.h"
+#include "case_server.h"
+#include "string_parser.h"
+
+namespace {
+
+std::string socket_path()
+{
+    return "/tmp/hiker_server_" + std::to_string(getpid()) + ".sock";
+}
+
+// A connection that sends requests until the server stops reading them and
+// never reads a response.
+int flood_without_reading(const std::string& socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    const char request[] = "A 100;100";
+    std::string frame(8, '\0');
+    uint32_t header[2] = {sizeof(request) - 1, static_cast<uint32_t>(CaseFormat::String)};
+    memcpy(&frame[0], header, sizeof(header));
+    frame += request;
+    std::string pending;
+    pollfd writable{fd, POLLOUT, 0};
+    // Until nothing could be sent for a while.
+    while (true) {
+        if (pending.empty()) {
+            pending = frame;
+        }
+        ssize_t count = send(fd, pending.data(), pending.size(), MSG_NOSIGNAL);
+        if (count > 0) {
+            pending.erase(0, count);
+        }
+        else if (poll(&writable, 1, 200) <= 0) {
+            break;
+        }
+    }
+    return fd;
+}
+
+const char kGoldenCase[] = "A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15";
+
+} // namespace
+
+TEST(CaseServerTest, SolvesStringAndBinaryCases) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse(kGoldenCase, origHikers, bridges);
+    std::string binaryPath = "/tmp/hiker_server_" + std::to_string(getpid()) + ".bin";
+    write_binary_case(binaryPath, origHikers, bridges);
+    std::ostringstream binary;
+    binary << std::ifstream(binaryPath, std::ios::binary).rdbuf();
+    std::remove(binaryPath.c_str());
+
+    Cache cache;
+    CaseServer server(socket_path(), 2, &cache);
+    CaseClient client(socket_path());
+    EXPECT_DOUBLE_EQ(client.solve(CaseFormat::String, kGoldenCase), 245);
+    EXPECT_DOUBLE_EQ(client.solve(CaseFormat::Binary, binary.str()), 245);
+    EXPECT_THROW(client.solve(CaseFormat::String, "A 100;-1"), std::invalid_argument);
+    EXPECT_THROW(client.solve(CaseFormat::Binary, "not a case"), std::invalid_argument);
+    EXPECT_THROW(client.solve(static_cast<CaseFormat>(7), kGoldenCase), std::invalid_argument);
+    // Still served after the errors.
+    EXPECT_DOUBLE_EQ(client.solve(CaseFormat::String, "A 100;100"), 1);
+
+    LatencyStats stats = server.takeLatencyStats();
+    EXPECT_EQ(stats.requestCount, 6u);
+    EXPECT_GE(stats.batchCount, 1u);
+    EXPECT_LE(stats.p50Micros, stats.p99Micros);
+    EXPECT_EQ(server.takeLatencyStats().requestCount, 0u);
+}
+
+// A well-formed binary case with a negative speed gets an error response,
+// and the server keeps going.
+TEST(CaseServerTest, RejectsInvalidBinaryCase) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50;100,C 20", origHikers, bridges);
+    std::string binaryPath = "/tmp/hiker_server_" + std::to_string(getpid()) + ".bin";
+    write_binary_case(binaryPath, origHikers, bridges);
+    std::ostringstream binary;
+    binary << std::ifstream(binaryPath, std::ios::binary).rdbuf();
+    std::remove(binaryPath.c_str());
+    std::string negative = binary.str();
+    double speed = -50;
+    memcpy(&negative[sizeof(BinaryCaseHeader) + sizeof(double)], &speed, sizeof(speed));
+
+    CaseServer server(socket_path(), 2);
+    CaseClient client(socket_path());
+    try {
+        client.solve(CaseFormat::Binary, negative);
+        ADD_FAILURE() << "negative speed accepted";
+    }
+    catch (const std::invalid_argument& e) {
+        EXPECT_EQ(std::string(e.what()), "Speed should > 0");
+    }
+    EXPECT_DOUBLE_EQ(client.solve(CaseFormat::Binary, binary.str()),
+        CaseClient(socket_path()).solve(CaseFormat::String, "A 100,B 50;100,C 20"));
+}
+
+// A client that only sends holds up its own connection, not the others.
+TEST(CaseServerTest, ClientNotReadingDoesNotStallOthers) {
+    CaseServer server(socket_path(), 2);
+    int fd = flood_without_reading(socket_path());
+    CaseClient client(socket_path());
+    EXPECT_DOUBLE_EQ(client.solve(CaseFormat::String, kGoldenCase), 245);
+    EXPECT_GE(server.takeLatencyStats().requestCount, kMaxCaseBacklog);
+    server.stop();
+    close(fd);
+}
+
+// A connection over kMaxCaseConnections is served once another one ends.
+TEST(CaseServerTest, CapsConnections) {
+    CaseServer server(socket_path(), 2);
+    std::vector<std::unique_ptr<CaseClient>> clients;
+    for (size_t i = 0; i < kMaxCaseConnections; ++i) {
+        clients.emplace_back(new CaseClient(socket_path()));
+        EXPECT_DOUBLE_EQ(clients.back()->solve(CaseFormat::String, "A 100;100"), 1);
+    }
+    std::atomic<bool> served(false);
+    std::thread waiting([&served] {
+        CaseClient client(socket_path());
+        EXPECT_DOUBLE_EQ(client.solve(CaseFormat::String, kGoldenCase), 245);
+        served = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(served);
+    clients.pop_back();
+    waiting.join();
+    EXPECT_TRUE(served);
+}
+
+TEST(CaseServerTest, ServesConcurrentClients) {
+    CaseServer server(socket_path(), 2);
+    std::vector<std::thread> clients;
+    std::vector<int> wrong(8, 0);
+    for (size_t i = 0; i < wrong.size(); ++i) {
+        clients.emplace_back([&, i] {
+            CaseClient client(socket_path());
+            for (int request = 0; request < 200; ++request) {
+                wrong[i] += client.solve(CaseFormat::String, kGoldenCase) != 245;
+                wrong[i] += client.solve(CaseFormat::String, "A 100;100") != 1;
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    for (int count : wrong) {
+        EXPECT_EQ(count, 0);
+    }
+    server.stop();
+    EXPECT_EQ(server.takeLatencyStats().requestCount, 8u * 400);
+    EXPECT_THROW(CaseClient client(socket_path()), std::runtime_error);
+}
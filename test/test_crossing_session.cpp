@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bridge.h"
+#include "cache.h"
+#include "calculator.h"
+#include "crossing_session.h"
+#include "fast_case_parser.h"
+#include "hiker.h"
+
+namespace {
+
+double solve_case(const std::string& strCase) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParseError error;
+    EXPECT_TRUE(FastCaseParser().parse(strCase, origHikers, bridges, error));
+    return CrossingTimeCalculator(nullptr).calcCrossingTime(bridges, origHikers, false);
+}
+
+} // namespace
+
+TEST(CrossingSessionTest, MatchesCalculatorBridgeByBridge) {
+    Cache cache(64 << 10);
+    CrossingSession session(&cache);
+    session.addHiker("A", 100);
+    session.addHiker("B", 50);
+    session.addHiker("C", 20);
+    session.addHiker("D", 10);
+    EXPECT_DOUBLE_EQ(session.addBridge(100), 17);
+    session.addHiker("E", 2.5);
+    session.addBridge(250);
+    EXPECT_DOUBLE_EQ(session.getTotalTime(),
+        solve_case("A 100,B 50,C 20,D 10;100;250,E 2.5"));
+    session.addHiker("F", 25);
+    session.addHiker("G", 15);
+    session.addBridge(150);
+    EXPECT_DOUBLE_EQ(session.getTotalTime(), 245);
+    EXPECT_EQ(session.getHikerCount(), 7u);
+    EXPECT_EQ(session.getBridgeCount(), 3u);
+
+    session.reset();
+    EXPECT_EQ(session.getHikerCount(), 0u);
+    EXPECT_DOUBLE_EQ(session.getTotalTime(), 0);
+}
+
+TEST(CrossingSessionTest, RemovedHikersStopCrossing) {
+    CrossingSession session;
+    session.addHiker("A", 100);
+    session.addHiker("B", 50);
+    session.addHiker("C", 20);
+    session.addHiker("D", 10);
+    session.addHiker("D", 15);
+    // The last D leaves, before any bridge.
+    EXPECT_TRUE(session.removeHiker("D"));
+    session.addBridge(100);
+    session.addHiker("E", 2.5);
+    session.addBridge(250);
+    EXPECT_TRUE(session.removeHiker("E"));
+    EXPECT_FALSE(session.removeHiker("E"));
+    EXPECT_FALSE(session.removeHiker("Z"));
+    double time = session.addBridge(150);
+    EXPECT_DOUBLE_EQ(time, solve_case("A 100,B 50,C 20,D 10;150"));
+    EXPECT_DOUBLE_EQ(session.getTotalTime(),
+        solve_case("A 100,B 50,C 20,D 10;100;250,E 2.5") + time);
+}
+
+TEST(CrossingSessionTest, RejectsBadEvents) {
+    CrossingSession session;
+    EXPECT_THROW(session.addHiker("A", 0), std::invalid_argument);
+    EXPECT_THROW(session.addBridge(100), std::invalid_argument);
+    session.addHiker("A", 100);
+    EXPECT_THROW(session.addBridge(-1), std::invalid_argument);
+    session.addBridge(100);
+    // Additional hikers cannot carry the torch back.
+    session.addHiker("B", 50);
+    EXPECT_TRUE(session.removeHiker("A"));
+    EXPECT_THROW(session.addBridge(100), std::invalid_argument);
+    EXPECT_EQ(session.getBridgeCount(), 1u);
+}
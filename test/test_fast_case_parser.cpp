@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "fast_case_parser.h"
+#include "string_parser.h"
+
+namespace {
+
+// Random well formed case with names and numbers of varied shapes.
+std::string random_case(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> count(1, 6);
+    std::uniform_int_distribution<int> newHikerCount(0, 4);
+    std::uniform_real_distribution<double> speed(0.01, 500);
+    const char* names[] = {"A", "Bob", "hiker_7", "X-1", "Zoë"};
+    std::ostringstream oss;
+    oss.precision(17);
+    int origCount = count(rng);
+    for (int i = 0; i < origCount; ++i) {
+        oss << (i ? "," : "") << names[rng() % 5] << i << " " << speed(rng);
+    }
+    int bridges = count(rng);
+    for (int i = 0; i < bridges; ++i) {
+        oss << ";" << speed(rng) * 10;
+        int hikers = newHikerCount(rng);
+        for (int j = 0; j < hikers; ++j) {
+            oss << "," << names[rng() % 5] << " " << speed(rng);
+        }
+    }
+    return oss.str();
+}
+
+void expect_same_hikers(const std::vector<Hiker>& lhs, const std::vector<Hiker>& rhs,
+    const std::string& strCase)
+{
+    ASSERT_EQ(lhs.size(), rhs.size()) << strCase;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        EXPECT_EQ(lhs[i].getName(), rhs[i].getName()) << strCase;
+        EXPECT_EQ(lhs[i].getSpeed(), rhs[i].getSpeed()) << strCase;
+    }
+}
+
+CaseParseError fast_parse_error(const std::string& strCase)
+{
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParseError error{0, nullptr};
+    EXPECT_FALSE(FastCaseParser().parse(strCase, origHikers, bridges, error)) << strCase;
+    return error;
+}
+
+} // namespace
+
+// CaseParser is the reference.
+TEST(FastCaseParserTest, MatchesCaseParser) {
+    std::mt19937 rng(11);
+    for (int i = 0; i < 1000; ++i) {
+        std::string strCase = random_case(rng);
+        std::vector<Hiker> origHikers;
+        std::vector<Bridge> bridges;
+        CaseParser().parse(strCase, origHikers, bridges);
+
+        std::vector<Hiker> fastOrigHikers;
+        std::vector<Bridge> fastBridges;
+        CaseParseError error;
+        ASSERT_TRUE(FastCaseParser().parse(strCase, fastOrigHikers, fastBridges, error))
+            << strCase << " at " << error.position << ": " << error.message;
+        expect_same_hikers(fastOrigHikers, origHikers, strCase);
+        ASSERT_EQ(fastBridges.size(), bridges.size()) << strCase;
+        for (size_t j = 0; j < bridges.size(); ++j) {
+            EXPECT_EQ(fastBridges[j].getLength(), bridges[j].getLength()) << strCase;
+            expect_same_hikers(fastBridges[j].getAdditionalHikers(),
+                bridges[j].getAdditionalHikers(), strCase);
+        }
+    }
+}
+
+TEST(FastCaseParserTest, ReportsErrorPosition) {
+    struct { const char* strCase; size_t position; } cases[] = {
+        {"A 100", 5},            // No bridge.
+        {"A 100,B;100", 7},      // No speed.
+        {"A 100,B x;100", 8},    // Invalid number.
+        {"A 100,B 0;100", 8},    // Speed <= 0.
+        {"A 100;-5", 6},         // Length <= 0.
+        {"A 100;100,E 2.5x", 15},
+        {"A 100;100;", 10},      // Empty bridge.
+        {"A 1e999;100", 2},      // Out of range.
+    };
+    for (auto& testCase : cases) {
+        CaseParseError error = fast_parse_error(testCase.strCase);
+        EXPECT_EQ(error.position, testCase.position) << testCase.strCase;
+        EXPECT_NE(error.message, nullptr);
+    }
+}
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "cache.h"
+#include "line_case_file.h"
+#include "thread_pool.h"
+
+namespace {
+
+std::string temp_path(const char* name)
+{
+    return std::string("/tmp/hiker_") + name + "_" + std::to_string(getpid()) + ".txt";
+}
+
+void write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+}
+
+} // namespace
+
+TEST(LineCaseFileTest, ChunksEndAfterNewline) {
+    std::string path = temp_path("chunks");
+    write_file(path, "aaaa\nbb\ncccccc\nd\n\ne");
+    {
+        LineCaseFile file(path);
+        EXPECT_EQ(file.getData().size(), 19u);
+        EXPECT_EQ(file.splitChunks(3), (std::vector<size_t>{0, 5, 8, 15, 18, 19}));
+        EXPECT_EQ(file.splitChunks(100), (std::vector<size_t>{0, 19}));
+    }
+    write_file(path, "");
+    {
+        LineCaseFile file(path);
+        EXPECT_EQ(file.splitChunks(3), (std::vector<size_t>{0, 0}));
+    }
+    std::remove(path.c_str());
+    EXPECT_THROW(LineCaseFile("/nonexistent/cases.txt"), std::runtime_error);
+}
+
+// More than a wave of chunks, so that the order of the output is checked.
+TEST(LineCaseFileTest, SolvesLinesInOrder) {
+    const char* cases[] = {
+        "A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15",
+        "A 100;100",
+        "A 64,B 32;128\r",
+        "",
+        "A 100;-1",
+    };
+    const char* results[] = {"245", "1", "4", "", "Parse case error at 6: Bridge's length should > 0"};
+    std::string input;
+    std::string expected;
+    size_t lineCount = 3 * 8 * kLineChunkBytes / 100;
+    for (size_t line = 0; line < lineCount; ++line) {
+        input += cases[line % 5];
+        input += '\n';
+        expected += results[line % 5];
+        expected += '\n';
+    }
+    std::string path = temp_path("solve");
+    write_file(path, input);
+    {
+        LineCaseFile file(path);
+        ThreadPool pool(2);
+        Cache cache;
+        std::ostringstream output;
+        LineCaseSummary summary = solve_line_cases(file, output, pool, &cache);
+        EXPECT_EQ(summary.caseCount, lineCount - lineCount / 5);
+        EXPECT_EQ(summary.errorCount, lineCount / 5);
+        EXPECT_TRUE(output.str() == expected);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "simd_kernels.h"
+
+namespace {
+
+std::vector<SimdLevel> supported_levels()
+{
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    if (get_simd_level() != SimdLevel::Scalar) {
+        levels.push_back(SimdLevel::AVX2);
+    }
+    if (get_simd_level() == SimdLevel::AVX512) {
+        levels.push_back(SimdLevel::AVX512);
+    }
+    return levels;
+}
+
+} // namespace
+
+// Sizes around the vector widths, lead times on both sides of the values.
+TEST(SimdKernelsTest, SumMaxWithinDocumentedBound) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> speed(0.5, 200);
+    for (size_t count : {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 100, 1001}) {
+        std::vector<double> perFeetTimes(count);
+        for (auto& perFeetTime : perFeetTimes) {
+            perFeetTime = 1 / speed(rng);
+        }
+        for (double lead : {0.001, 0.01, 0.1, 10.0}) {
+            double expected = sum_max_per_feet_time(perFeetTimes.data(), count, lead,
+                SimdLevel::Scalar);
+            double bound = (count > 0 ? count - 1 : 0) *
+                std::numeric_limits<double>::epsilon() * expected;
+            for (auto level : supported_levels()) {
+                double sum = sum_max_per_feet_time(perFeetTimes.data(), count, lead, level);
+                EXPECT_LE(std::fabs(sum - expected), bound)
+                    << simd_level_name(level) << " count " << count;
+            }
+        }
+    }
+}
+
+TEST(SimdKernelsTest, CountIsExact) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> speed(1, 20);
+    for (size_t count : {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 500}) {
+        std::vector<double> speeds(count);
+        for (auto& value : speeds) {
+            value = speed(rng) * 5.0;
+        }
+        for (double threshold : {0.0, 5.0, 33.3, 50.0, 1000.0}) {
+            size_t expected = count_speed_slower_than(speeds.data(), count, threshold,
+                SimdLevel::Scalar);
+            for (auto level : supported_levels()) {
+                EXPECT_EQ(count_speed_slower_than(speeds.data(), count, threshold, level),
+                    expected) << simd_level_name(level) << " count " << count;
+            }
+        }
+    }
+}
+
+// Every position around the vector width, with and without a later match.
+TEST(SimdKernelsTest, FindByteFindsFirst) {
+    for (size_t size : {0, 1, 31, 32, 33, 64, 100}) {
+        for (size_t at = 0; at <= size; ++at) {
+            std::string data(size, 'a');
+            if (at < size) {
+                data[at] = '\n';
+                data[size - 1] = '\n';
+            }
+            for (auto level : supported_levels()) {
+                EXPECT_EQ(find_byte(data.data(), size, '\n', level), at)
+                    << simd_level_name(level) << " size " << size;
+            }
+        }
+    }
+}
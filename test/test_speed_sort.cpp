@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "speed_sort.h"
+#include "utils.h"
+
+TEST(SpeedSortTest, RadixMatchesStableSort) {
+    std::mt19937 rng(20241016);
+    // Repeated speeds, and scales far apart so that every digit matters.
+    std::uniform_int_distribution<int> mantissa(1, 50);
+    std::uniform_int_distribution<int> scale(-20, 20);
+    for (size_t count : {0, 1, 2, 100, 5000}) {
+        std::vector<double> speeds(count);
+        for (auto& speed : speeds) {
+            speed = std::ldexp(mantissa(rng) * 0.5, scale(rng));
+        }
+        std::vector<uint32_t> expected(count);
+        std::iota(expected.begin(), expected.end(), 0);
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return speeds[lhs] > speeds[rhs];
+        });
+        std::vector<uint32_t> rows(count);
+        std::iota(rows.begin(), rows.end(), 0);
+        radix_sort_rows_by_speed(speeds.data(), rows);
+        EXPECT_EQ(rows, expected) << count;
+        std::iota(rows.begin(), rows.end(), 0);
+        sort_rows_by_speed(speeds.data(), rows);
+        EXPECT_EQ(rows, expected) << count;
+    }
+}
+
+TEST(SpeedSortTest, SortsManyHikersByIndex) {
+    std::vector<Hiker> hikers;
+    for (int i = 0; i < 1000; ++i) {
+        hikers.emplace_back("H" + std::to_string(i), 1 + i % 7);
+    }
+    sort_hikers(hikers);
+    for (size_t i = 1; i < hikers.size(); ++i) {
+        ASSERT_GE(hikers[i - 1].getSpeed(), hikers[i].getSpeed());
+    }
+    // Ties keep their input order.
+    EXPECT_EQ(hikers[0].getName(), "H6");
+    EXPECT_EQ(hikers[1].getName(), "H13");
+}
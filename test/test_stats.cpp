@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "calculator.h"
+#include "stats.h"
+#include "string_parser.h"
+
+namespace {
+
+size_t count_of(const std::string& str, const std::string& part)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(part); pos != std::string::npos; pos = str.find(part, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(StatsTest, CountsBridgesAndSpans) {
+    if (!Stats::isCompiledIn()) {
+        GTEST_SKIP() << "Built without HIKER_STATS";
+    }
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50,C 20,D 10;100;250,E 2.5;150,F 25,G 15",
+        origHikers, bridges);
+    Stats& stats = Stats::instance();
+    stats.reset();
+    stats.setEnabled(true);
+    stats.setTracing(true);
+    CrossingTimeCalculator calc(nullptr);
+    for (auto engine : {CrossingTimeCalculator::Engine::Greedy,
+        CrossingTimeCalculator::Engine::Incremental, CrossingTimeCalculator::Engine::Profile}) {
+        calc.setEngine(engine);
+        calc.calcCrossingTime(bridges, origHikers, false);
+    }
+    stats.setEnabled(false);
+    stats.setTracing(false);
+
+    // Groups of 4, 5 and 7 hikers, solved by each engine.
+    EXPECT_EQ(stats.getCount(StatCounter::Bridges), 9u);
+    EXPECT_EQ(stats.getCount(StatCounter::HikersProcessed), 48u);
+    // One slow pair (C and D, then D and E) at the first two bridges, two
+    // at the third; each engine solves every group once.
+    EXPECT_EQ(stats.getCount(StatCounter::SlowPairs), 3u * 4u);
+    EXPECT_EQ(stats.getSpanCount(StatPhase::Solve), 9u);
+    EXPECT_GT(stats.getTime(StatPhase::Solve), 0u);
+
+    std::ostringstream json;
+    stats.writeJSON(json, nullptr);
+    EXPECT_NE(json.str().find("\"bridges\":9"), std::string::npos) << json.str();
+    EXPECT_EQ(json.str().find("\"cache\""), std::string::npos);
+    std::ostringstream trace;
+    stats.writeTrace(trace);
+    EXPECT_EQ(count_of(trace.str(), "\"name\":\"bridge\""), 9u);
+    stats.reset();
+}
+
+TEST(StatsTest, NothingRecordedWhenDisabled) {
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    CaseParser().parse("A 100,B 50,C 20,D 10;100", origHikers, bridges);
+    Stats& stats = Stats::instance();
+    stats.reset();
+    CrossingTimeCalculator(nullptr).calcCrossingTime(bridges, origHikers, false);
+    EXPECT_EQ(stats.getCount(StatCounter::Bridges), 0u);
+    EXPECT_EQ(stats.getSpanCount(StatPhase::Parse), 0u);
+}
@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST(ThreadPoolTest, RunsEachTaskOnce) {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.getThreadCount(), 4u);
+    for (size_t count : {0, 1, 3, 4, 1000}) {
+        std::vector<std::atomic<int>> runs(count);
+        for (auto& run : runs) {
+            run = 0;
+        }
+        std::atomic<bool> workerInRange(true);
+        pool.parallelFor(count, [&](size_t index, size_t worker) {
+            ++runs[index];
+            if (worker >= pool.getThreadCount()) {
+                workerInRange = false;
+            }
+        });
+        for (auto& run : runs) {
+            EXPECT_EQ(run, 1);
+        }
+        EXPECT_TRUE(workerInRange);
+    }
+}
+
+// A few slow tasks at the front must not keep the other workers idle.
+TEST(ThreadPoolTest, StealsFromBusyWorkers) {
+    ThreadPool pool(2);
+    std::vector<size_t> workers(100);
+    pool.parallelFor(workers.size(), [&](size_t index, size_t worker) {
+        workers[index] = worker;
+        if (index == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+    size_t byWorker1 = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        byWorker1 += workers[i] == 1;
+    }
+    EXPECT_GT(byWorker1, 50u);
+}
+
+TEST(ThreadPoolTest, RethrowsTaskError) {
+    ThreadPool pool(3);
+    std::atomic<int> runs(0);
+    EXPECT_THROW(pool.parallelFor(10, [&](size_t index, size_t) {
+        ++runs;
+        if (index == 5) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    EXPECT_EQ(runs, 10);
+    // Still usable.
+    pool.parallelFor(10, [&](size_t, size_t) { ++runs; });
+    EXPECT_EQ(runs, 20);
+}
+
+TEST(ThreadPoolTest, ParsesThreadCount) {
+    size_t threadCount = 7;
+    EXPECT_TRUE(parse_thread_count("16", threadCount));
+    EXPECT_EQ(threadCount, 16u);
+    EXPECT_TRUE(parse_thread_count("0", threadCount));
+    EXPECT_EQ(threadCount, 0u);
+    for (const char* bad : {"", "x", "-1", "4x", " 4", "1025", "99999999999999999999"}) {
+        EXPECT_FALSE(parse_thread_count(bad, threadCount)) << bad;
+    }
+    EXPECT_EQ(threadCount, 0u);
+}
@@ -0,0 +1,171 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+#include "hiker.h"
+#include "bridge.h"
+#include "streaming_solver.h"
+#include "yaml_event_parser.h"
+#include "yaml_parser.h"
+
+namespace {
+
+// The case as text, or the error message.
+std::string describe(const std::vector<Hiker>& origHikers, const std::vector<Bridge>& bridges)
+{
+    std::ostringstream oss;
+    for (auto& hiker : origHikers) {
+        oss << hiker.getName() << " " << hiker.getSpeed() << ",";
+    }
+    for (auto& bridge : bridges) {
+        oss << ";" << bridge.getLength();
+        for (auto& hiker : bridge.getAdditionalHikers()) {
+            oss << "," << hiker.getName() << " " << hiker.getSpeed();
+        }
+    }
+    return oss.str();
+}
+
+std::string parse_dom(const std::string& yaml)
+{
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    try {
+        YAMLCaseParser().parse(YAML::Load(yaml), origHikers, bridges);
+    }
+    catch (const std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+    return describe(origHikers, bridges);
+}
+
+std::string parse_events(const std::string& yaml)
+{
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    try {
+        std::istringstream in(yaml);
+        YAMLEventCaseParser().parse(in, origHikers, bridges);
+    }
+    catch (const std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+    return describe(origHikers, bridges);
+}
+
+// Random case in block or flow style, with extra keys the parsers skip.
+std::string random_yaml(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> count(1, 5);
+    std::uniform_int_distribution<int> speed(1, 400);
+    std::ostringstream oss;
+    oss << "comment: {a: [1, 2], b: x}\nhikers:\n";
+    int origCount = count(rng);
+    for (int i = 0; i < origCount; ++i) {
+        oss << "- {name: H" << i << ", speed: " << speed(rng) * 0.25 << ", note: [x]}\n";
+    }
+    oss << "bridges:\n";
+    int bridgeCount = count(rng);
+    for (int i = 0; i < bridgeCount; ++i) {
+        bool hikersFirst = rng() % 2;
+        int hikerCount = count(rng) - 1;
+        oss << "- ";
+        if (!hikersFirst) {
+            oss << "length: " << speed(rng) << "\n  ";
+        }
+        oss << "hikers:" << (hikerCount ? "\n" : " []\n");
+        for (int j = 0; j < hikerCount; ++j) {
+            oss << "  - name: X" << i << j << "\n    speed: " << speed(rng) * 0.5 << "\n";
+        }
+        if (hikersFirst) {
+            oss << "  length: " << speed(rng) << "\n";
+        }
+    }
+    return oss.str();
+}
+
+} // namespace
+
+TEST(YAMLEventCaseParserTest, MatchesDOMParser) {
+    std::mt19937 rng(3);
+    for (int i = 0; i < 300; ++i) {
+        std::string yaml = random_yaml(rng);
+        EXPECT_EQ(parse_events(yaml), parse_dom(yaml)) << yaml;
+    }
+    // The first of duplicate keys is the one looked up.
+    const char* duplicateKeys[] = {
+        "hikers:\n- {name: A, speed: 100}\nbridges:\n- length: 200\n"
+            "bridges:\n- length: 400\n- length: 200\n",
+        "hikers:\n- {name: A, speed: 100}\nhikers:\n- {name: B, speed: 50}\n"
+            "bridges:\n- length: 200\n",
+        "hikers:\n- {name: A, speed: 100}\nbridges:\n- length: 200\n  length: 400\n"
+            "  hikers: [{name: C, speed: 10}]\n  hikers: [{name: D, speed: 1}]\n",
+        "hikers: 5\nhikers:\n- {name: A, speed: 100}\nbridges:\n- length: 200\n",
+        "hikers:\n- {name: A, speed: 100}\nbridges: 5\nbridges:\n- length: 200\n",
+        "hikers:\n- {name: A, speed: 100}\nbridges:\n- length: 200\n  hikers: {}\n"
+            "  hikers: [{name: C, speed: 10}]\n",
+    };
+    for (auto& yaml : duplicateKeys) {
+        EXPECT_EQ(parse_events(yaml), parse_dom(yaml)) << yaml;
+    }
+}
+
+TEST(YAMLEventCaseParserTest, SameErrorsAsDOMParser) {
+    const char* documents[] = {
+        "",
+        "42",
+        "hikers: 5\nbridges:\n- length: 5\n",
+        "bridges:\n- length: 100\n",
+        "hikers:\n- name: A\n  speed: 1\n",
+        "hikers:\n- speed: 100\nbridges:\n- length: 100\n",
+        "hikers:\n- name: A\n  speed: fast\nbridges:\n- length: 100\n",
+        "hikers:\n- name: A\n  speed: -1\nbridges:\n- length: 100\n",
+        "hikers:\n- name: [A]\n  speed: 1\nbridges:\n- length: 100\n",
+        "hikers:\n- name:\n  speed: 1\nbridges:\n- length: 100\n",
+        "hikers:\n- A\nbridges:\n- length: 100\n",
+        "hikers:\n- name: A\n  speed: 100\nbridges:\n- hikers: []\n",
+        "hikers:\n- name: A\n  speed: 100\nbridges:\n- 100\n",
+        "hikers:\n- name: A\n  speed: 100\nbridges:\n- length: 0\n",
+        "hikers:\n- name: A\n  speed: 100\nbridges:\n- length: 5\n  hikers:\n"
+            "  - name: B\n    speed: 0x10\n",
+        "hikers:\n- name: A\n  speed: 1e400\nbridges:\n- length: 100\n",
+        "hikers:\n- name: A\n  speed: &s 100\nbridges:\n- length: *s\n",
+        "bridges:\n- length: 10\n  hikers:\n  - name: B\n    speed: 5\nhikers:\n"
+            "- name: A\n  speed: 100\n",
+        "hikers: [{name: A, speed: 100}, {name: B, speed: 50}]\nbridges: [{length: 1}]",
+        "hikers:\n- name: A\n  speed: 100\nbridges:\n- length: [1\n",
+    };
+    for (auto& yaml : documents) {
+        EXPECT_EQ(parse_events(yaml), parse_dom(yaml)) << yaml;
+    }
+}
+
+TEST(YAMLEventCaseParserTest, FeedsBridgesToHandler) {
+    std::istringstream in("hikers:\n- {name: A, speed: 100}\n- {name: B, speed: 50}\n"
+        "- {name: C, speed: 20}\n- {name: D, speed: 10}\nbridges:\n- length: 100\n"
+        "- length: 250\n  hikers:\n  - {name: E, speed: 2.5}\n"
+        "- length: 150\n  hikers:\n  - {name: F, speed: 25}\n  - {name: G, speed: 15}\n");
+    StreamingSolver solver;
+    std::vector<double> totals;
+    solver.setListener([&totals](size_t, double, double totalTime) {
+        totals.push_back(totalTime);
+    });
+    YAMLEventCaseParser().parse(in, solver);
+    ASSERT_EQ(totals.size(), 3u);
+    EXPECT_NEAR(totals[0], 17, 1e-9);
+    EXPECT_NEAR(totals[2], 245, 1e-9);
+}
+
+TEST(YAMLEventCaseParserTest, LogsHikerErrorsToGivenStream) {
+    std::istringstream in("hikers:\n- name: A\n  speed: -1\nbridges:\n- length: 100\n");
+    std::ostringstream log;
+    std::vector<Hiker> origHikers;
+    std::vector<Bridge> bridges;
+    EXPECT_THROW(YAMLEventCaseParser(log).parse(in, origHikers, bridges), std::out_of_range);
+    EXPECT_EQ(log.str(), "Parse hiker error: Speed should > 0\n");
+}